@@ -1,9 +1,11 @@
+#include <chrono>
 #include <iostream>
 #include <string>
 #include <thread>
 
 #include "timer/LoopTimer.h"
 #include "redis/RedisClient.h"
+#include "redis/RedisClientPool.h"
 
 #include <signal.h>
 bool stopRunning = false;
@@ -13,6 +15,7 @@ using namespace std;
 using namespace Eigen;
 
 void second_program();
+void compare_tcp_and_unix_socket_latency(const string& socket_path);
 
 const string STR_KEY = "str_key";
 const string INT_KEY = "int_key";
@@ -23,6 +26,9 @@ const string MATRIX_KEY = "matrix_key";
 
 const string prefix = "sai-common-example";
 
+// pool giving one redis client to each thread
+SaiCommon::RedisClientPool redis_pool(prefix);
+
 int main(int argc, char** argv) {
 	// example data that a robot would have
 	int robot_dofs = 2;
@@ -37,9 +43,10 @@ int main(int argc, char** argv) {
 	signal(SIGTERM, &sighandler);
 	signal(SIGINT, &sighandler);
 
-	// make redis client
-	SaiCommon::RedisClient redis_client(prefix);
-	redis_client.connect();
+	// connect the clients of both threads in advance, and get the client of
+	// this thread
+	redis_pool.preconnect(2);
+	SaiCommon::RedisClient& redis_client = redis_pool.client();
 
 	// set some values in redis database
 	redis_client.set(STR_KEY, "Hello World !");
@@ -98,6 +105,10 @@ int main(int argc, char** argv) {
 
 	second_thread.join();
 
+	// compare the latency of a TCP loopback connection and a unix domain
+	// socket connection. The socket path can be given as first argument
+	compare_tcp_and_unix_socket_latency(argc > 1 ? argv[1] : "/tmp/redis.sock");
+
 	// delete keys
 	redis_client.del(STR_KEY);
 	redis_client.del(INT_KEY);
@@ -111,9 +122,8 @@ int main(int argc, char** argv) {
 
 void second_program() {
 
-	// make second redis client connected to the same database
-	SaiCommon::RedisClient redis_client_2(prefix);
-	redis_client_2.connect();
+	// get the redis client of this thread, connected to the same database
+	SaiCommon::RedisClient& redis_client_2 = redis_pool.client();
 
 	cout << endl;
 	cout << "keys read from thread 2 before the loop: " << endl;
@@ -157,8 +167,8 @@ void second_program() {
 			enable_safety = true;
 		}
 
-		redis_client_2.sendAllFromGroup();
-		redis_client_2.receiveAllFromGroup();
+		// send and receive in a single round trip to redis
+		redis_client_2.sendAndReceiveAllFromGroup();
 
 		cout << "robot info received from first thread:" << endl;
 		cout << "robot joint angles:\n" << robot_q.transpose() << endl;
@@ -166,3 +176,45 @@ void second_program() {
 		cout << endl;
 	}
 }
+
+// average time of a send and receive cycle, in microseconds
+double measure_round_trip_latency(SaiCommon::RedisClient& redis_client,
+								  const int n_cycles) {
+	Matrix2d matrix = Matrix2d::Identity();
+	Vector2d vector = Vector2d::Zero();
+	redis_client.createNewSendGroup("latency");
+	redis_client.createNewReceiveGroup("latency");
+	redis_client.addToSendGroup(MATRIX_KEY, matrix, "latency");
+	redis_client.addToReceiveGroup(VECTOR_KEY, vector, "latency");
+
+	auto start = chrono::high_resolution_clock::now();
+	for (int i = 0; i < n_cycles; ++i) {
+		redis_client.sendAndReceiveAllFromGroup("latency", "latency");
+	}
+	auto end = chrono::high_resolution_clock::now();
+	return chrono::duration<double, micro>(end - start).count() / n_cycles;
+}
+
+void compare_tcp_and_unix_socket_latency(const string& socket_path) {
+	const int n_cycles = 10000;
+
+	SaiCommon::RedisClient tcp_client(prefix);
+	tcp_client.connect();
+	double tcp_latency = measure_round_trip_latency(tcp_client, n_cycles);
+
+	SaiCommon::RedisClient unix_client(prefix);
+	try {
+		unix_client.connect("unix://" + socket_path);
+	} catch (const std::exception& e) {
+		cout << "could not connect to redis through the unix socket "
+			 << socket_path << ", start the server with:" << endl;
+		cout << "redis-server --unixsocket " << socket_path << endl << endl;
+		return;
+	}
+	double unix_latency = measure_round_trip_latency(unix_client, n_cycles);
+
+	cout << "average send and receive round trip over " << n_cycles
+		 << " cycles:" << endl;
+	cout << "TCP loopback: " << tcp_latency << " us" << endl;
+	cout << "unix socket:  " << unix_latency << " us" << endl << endl;
+}
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "redis/RedisClient.h"
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+
+// text encoding used before the std::to_chars formatting: std::to_string
+// (snprintf "%f", 6 decimals)
+string encodeEigenMatrixToString(const MatrixXd& matrix) {
+	string s = "[";
+	if (matrix.cols() == 1) {
+		for (int i = 0; i < matrix.rows(); ++i) {
+			if (i > 0) s.append(",");
+			s.append(to_string(matrix(i, 0)));
+		}
+	} else {
+		for (int i = 0; i < matrix.rows(); ++i) {
+			if (i > 0) s.append(",");
+			if (matrix.rows() > 1) s.append("[");
+			for (int j = 0; j < matrix.cols(); ++j) {
+				if (j > 0) s.append(",");
+				s.append(to_string(matrix(i, j)));
+			}
+			if (matrix.rows() > 1) s.append("]");
+		}
+	}
+	s.append("]");
+	return s;
+}
+
+// run an encoder for about 0.2 seconds and print the number of encodes per
+// second, the throughput in coefficients per second and the payload size
+template <typename Encoder>
+void benchmark(const string& name, const MatrixXd& matrix,
+			   const Encoder& encode) {
+	size_t payload_size = encode(matrix).size();
+	size_t num_encodes = 0;
+	const auto start = chrono::steady_clock::now();
+	double elapsed = 0;
+	while (elapsed < 0.2) {
+		for (int k = 0; k < 10; ++k) {
+			payload_size = encode(matrix).size();
+		}
+		num_encodes += 10;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - start)
+					  .count();
+	}
+	const double encodes_per_second = num_encodes / elapsed;
+	printf("  %-28s %12.0f encodes/s %10.2f Mcoeffs/s %9zu bytes\n",
+		   name.c_str(), encodes_per_second,
+		   encodes_per_second * matrix.size() * 1e-6, payload_size);
+}
+
+}  // namespace
+
+int main() {
+	cout << endl
+		 << "This example benchmarks the encoding of Eigen matrices written to "
+			"redis, for the text formats (std::to_string used previously, "
+			"shortest exact representation, 6 significant digits) and the "
+			"binary format. No redis server is needed."
+		 << endl
+		 << endl;
+
+	// values with a wide range of magnitudes, as joint positions and
+	// velocities of a robot
+	for (const int size : {1, 3, 7, 10, 30, 100}) {
+		MatrixXd matrix = MatrixXd::Random(size, size);
+		matrix(0, 0) = 1e-7;
+
+		cout << size << "x" << size << " matrix:" << endl;
+		benchmark("text, std::to_string", matrix, [](const MatrixXd& m) {
+			return encodeEigenMatrixToString(m);
+		});
+		benchmark("text, shortest exact", matrix, [](const MatrixXd& m) {
+			return SaiCommon::RedisClient::encodeEigenMatrix(m);
+		});
+		benchmark("text, 6 significant digits", matrix, [](const MatrixXd& m) {
+			return SaiCommon::RedisClient::encodeEigenMatrix(m, 6);
+		});
+		benchmark("binary", matrix, [](const MatrixXd& m) {
+			return SaiCommon::RedisClient::encodeEigenMatrixBinary(m);
+		});
+		cout << endl;
+	}
+
+	// precision of the text formats
+	const double small_value = 1e-7;
+	cout << "1e-7 encoded with std::to_string: "
+		 << encodeEigenMatrixToString(MatrixXd::Constant(1, 1, small_value))
+		 << ", with the shortest exact representation: "
+		 << SaiCommon::RedisClient::encodeEigenMatrix(
+				MatrixXd::Constant(1, 1, small_value))
+		 << endl
+		 << endl;
+
+	return 0;
+}
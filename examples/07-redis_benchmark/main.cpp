@@ -0,0 +1,213 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "redis/RedisClient.h"
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+
+// number of operator new calls of the program, to count the allocations of
+// the measured calls. The allocations of hiredis (malloc) are not counted
+atomic<uint64_t> num_allocations(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+	num_allocations.fetch_add(1, memory_order_relaxed);
+	if (void* ptr = malloc(size == 0 ? 1 : size)) return ptr;
+	throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+namespace {
+
+const vector<int> KEY_COUNTS = {1, 10, 100, 1000, 10000};
+const vector<int> MATRIX_SIZES = {1, 3, 10, 30, 100};
+
+// redis server started for the benchmark on a temporary unix socket, without
+// persistence, and stopped when the object is destroyed
+class LocalRedisServer {
+public:
+	LocalRedisServer(const string& executable)
+		: _socket_path("/tmp/sai-common-benchmark-" + to_string(getpid()) +
+					   ".sock") {
+		_pid = fork();
+		if (_pid == 0) {
+			execlp(executable.c_str(), executable.c_str(), "--port", "0",
+				   "--unixsocket", _socket_path.c_str(), "--save", "",
+				   "--appendonly", "no", nullptr);
+			_exit(127);
+		}
+		if (_pid < 0) throw runtime_error("Could not start " + executable);
+	}
+
+	~LocalRedisServer() {
+		if (_pid > 0) {
+			kill(_pid, SIGTERM);
+			waitpid(_pid, nullptr, 0);
+		}
+		unlink(_socket_path.c_str());
+	}
+
+	// connect a client, waiting up to 5 seconds for the server to start
+	void connect(SaiCommon::RedisClient& client) {
+		for (int attempt = 0; attempt < 100; ++attempt) {
+			if (waitpid(_pid, nullptr, WNOHANG) == _pid) {
+				_pid = 0;
+				throw runtime_error(
+					"redis-server exited, is it installed? (its path can be "
+					"given as argument)");
+			}
+			try {
+				client.connect(hostname());
+				return;
+			} catch (const exception&) {
+				this_thread::sleep_for(chrono::milliseconds(50));
+			}
+		}
+		throw runtime_error("Could not connect to redis-server");
+	}
+
+	string hostname() const { return "unix://" + _socket_path; }
+
+private:
+	const string _socket_path;
+	pid_t _pid = 0;
+};
+
+// call a function for about 0.2 seconds (at least 10 times) after a few
+// warmup calls, then print the latency percentiles and the number of
+// allocations per call
+template <typename Function>
+void measure(const string& name, const string& size, const Function& call) {
+	for (int i = 0; i < 3; ++i) call();
+
+	vector<double> latencies;
+	latencies.reserve(100000);
+	const uint64_t start_allocations = num_allocations.load();
+	const auto start = chrono::steady_clock::now();
+	auto now = start;
+	while ((latencies.size() < 10 || now - start < chrono::milliseconds(200)) &&
+		   latencies.size() < latencies.capacity()) {
+		call();
+		const auto end = chrono::steady_clock::now();
+		latencies.push_back(chrono::duration<double, micro>(end - now).count());
+		now = end;
+	}
+	const double allocations_per_call =
+		double(num_allocations.load() - start_allocations) / latencies.size();
+
+	sort(latencies.begin(), latencies.end());
+	const auto percentile = [&latencies](const double fraction) {
+		return latencies[min(latencies.size() - 1,
+							 size_t(fraction * latencies.size()))];
+	};
+	printf("  %-22s %9s %10.1f %10.1f %10.1f %12.1f\n", name.c_str(),
+		   size.c_str(), percentile(0.5), percentile(0.99), latencies.back(),
+		   allocations_per_call);
+}
+
+void printHeader(const string& size_name) {
+	printf("\n  %-22s %9s %10s %10s %10s %12s\n", "operation", size_name.c_str(),
+		   "p50 (us)", "p99 (us)", "max (us)", "allocs/call");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	cout << endl
+		 << "This example benchmarks the RedisClient functions against a "
+			"redis-server started on a temporary unix socket. The latencies "
+			"include the encoding and decoding of the values. The allocations "
+			"are the operator new calls, the allocations of hiredis are not "
+			"counted. The redis-server executable can be given as argument."
+		 << endl;
+
+	const string executable = argc > 1 ? argv[1] : "redis-server";
+	LocalRedisServer server(executable);
+	SaiCommon::RedisClient redis_client("sai-benchmark");
+	try {
+		server.connect(redis_client);
+	} catch (const exception& e) {
+		cout << endl << e.what() << endl << endl;
+		return 1;
+	}
+
+	// single keys
+	printHeader("value");
+	redis_client.set("string", "1.5");
+	measure("set", "string", [&]() { redis_client.set("string", "1.5"); });
+	measure("get", "string", [&]() { redis_client.get("string"); });
+
+	// Eigen matrices
+	printHeader("matrix");
+	for (const int size : MATRIX_SIZES) {
+		const string size_name = to_string(size) + "x" + to_string(size);
+		const MatrixXd matrix = MatrixXd::Random(size, size);
+		measure("setEigen", size_name,
+				[&]() { redis_client.setEigen("matrix", matrix); });
+		measure("getEigen", size_name,
+				[&]() { redis_client.getEigen("matrix"); });
+
+		auto send_group = redis_client.createNewSendGroup("matrix_send");
+		auto receive_group = redis_client.createNewReceiveGroup("matrix_receive");
+		MatrixXd received_matrix = MatrixXd::Zero(size, size);
+		redis_client.addToSendGroup("matrix", matrix, send_group);
+		redis_client.addToReceiveGroup("matrix", received_matrix,
+									   receive_group);
+		measure("sendAllFromGroup", size_name,
+				[&]() { redis_client.sendAllFromGroup(send_group); });
+		measure("receiveAllFromGroup", size_name,
+				[&]() { redis_client.receiveAllFromGroup(receive_group); });
+		redis_client.deleteSendGroup("matrix_send");
+		redis_client.deleteReceiveGroup("matrix_receive");
+	}
+
+	// many keys in one call, with double values
+	printHeader("keys");
+	for (const int num_keys : KEY_COUNTS) {
+		const string size_name = to_string(num_keys);
+		vector<string> keys;
+		vector<pair<string, string>> keyvals;
+		vector<double> values(num_keys, 1.5), received_values(num_keys, 0);
+		auto send_group = redis_client.createNewSendGroup("keys_send");
+		auto receive_group = redis_client.createNewReceiveGroup("keys_receive");
+		for (int i = 0; i < num_keys; ++i) {
+			keys.push_back("key_" + to_string(i));
+			keyvals.emplace_back(keys.back(), "1.5");
+			redis_client.addToSendGroup(keys.back(), values[i], send_group);
+			redis_client.addToReceiveGroup(keys.back(), received_values[i],
+										   receive_group);
+		}
+
+		measure("mset", size_name, [&]() { redis_client.mset(keyvals); });
+		measure("mget", size_name, [&]() { redis_client.mget(keys); });
+		measure("pipeset", size_name, [&]() { redis_client.pipeset(keyvals); });
+		measure("pipeget", size_name, [&]() { redis_client.pipeget(keys); });
+		measure("sendAllFromGroup", size_name,
+				[&]() { redis_client.sendAllFromGroup(send_group); });
+		measure("receiveAllFromGroup", size_name,
+				[&]() { redis_client.receiveAllFromGroup(receive_group); });
+		redis_client.deleteSendGroup("keys_send");
+		redis_client.deleteReceiveGroup("keys_receive");
+	}
+	cout << endl;
+
+	return 0;
+}
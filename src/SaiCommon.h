@@ -4,6 +4,7 @@
 #include "filters/ButterworthFilter.h"
 #include "logger/Logger.h"
 #include "redis/RedisClient.h"
+#include "redis/RedisClientPool.h"
 #include "timer/LoopTimer.h"
 
 #endif // SAI_COMMON_H_
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "InProcessTransport.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+namespace SaiCommon {
+
+namespace {
+
+// how many times a reader waits for a write of the value it copies before
+// failing
+constexpr int MAX_READ_ATTEMPTS = 10000;
+
+}  // namespace
+
+InProcessStore::InProcessStore() {
+	for (auto& bucket : _buckets) bucket.store(nullptr);
+}
+
+InProcessStore::~InProcessStore() {
+	for (auto& bucket : _buckets) {
+		Entry* entry = bucket.load();
+		while (entry) {
+			Entry* next = entry->next;
+			for (Buffer* buffer : entry->buffers) ::operator delete(buffer);
+			delete entry;
+			entry = next;
+		}
+	}
+}
+
+std::shared_ptr<InProcessStore> InProcessStore::endpoint(
+	const std::string& name) {
+	static std::mutex mutex;
+	static std::map<std::string, std::weak_ptr<InProcessStore>> stores;
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<InProcessStore> store = stores[name].lock();
+	if (!store) {
+		store = std::make_shared<InProcessStore>();
+		stores[name] = store;
+	}
+	return store;
+}
+
+size_t InProcessStore::bucketIndex(const EntryType type,
+								   const std::string& key,
+								   const std::string& field) {
+	size_t hash = std::hash<std::string>()(key);
+	if (type == FIELD_ENTRY) {
+		hash ^= std::hash<std::string>()(field) + 0x9e3779b97f4a7c15ULL +
+				(hash << 6) + (hash >> 2);
+	}
+	return (hash + type) & (NUM_BUCKETS - 1);
+}
+
+const InProcessStore::Entry* InProcessStore::find(
+	const EntryType type, const std::string& key,
+	const std::string& field) const {
+	const Entry* entry =
+		_buckets[bucketIndex(type, key, field)].load(std::memory_order_acquire);
+	for (; entry; entry = entry->next) {
+		if (entry->type == type && entry->key == key &&
+			(type != FIELD_ENTRY || entry->field == field)) {
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+InProcessStore::Entry& InProcessStore::findOrInsert(const EntryType type,
+													const std::string& key,
+													const std::string& field) {
+	if (const Entry* entry = find(type, key, field)) {
+		return const_cast<Entry&>(*entry);
+	}
+
+	// the fields of a hash are inserted with its mutex held: the field is in
+	// the list of the hash before it can be found and written
+	Entry* hash = nullptr;
+	std::unique_lock<std::mutex> hash_lock;
+	if (type == FIELD_ENTRY) {
+		hash = &findOrInsert(HASH_ENTRY, key, key);
+		hash_lock = std::unique_lock<std::mutex>(hash->mutex);
+		if (const Entry* entry = find(type, key, field)) {
+			return const_cast<Entry&>(*entry);
+		}
+	}
+
+	Entry* entry = new Entry();
+	entry->type = type;
+	entry->key = key;
+	if (type == FIELD_ENTRY) {
+		entry->field = field;
+		entry->hash = hash;
+		entry->next_field = hash->fields.load(std::memory_order_relaxed);
+		hash->fields.store(entry, std::memory_order_release);
+	}
+
+	// push on the bucket, unless another thread inserted the same entry
+	// (only a string or hash entry, the fields are inserted under the mutex)
+	auto& bucket = _buckets[bucketIndex(type, key, field)];
+	Entry* head = bucket.load(std::memory_order_acquire);
+	do {
+		for (Entry* other = head; other != entry->next; other = other->next) {
+			if (other->type == type && other->key == key &&
+				(type != FIELD_ENTRY || other->field == field)) {
+				delete entry;
+				return *other;
+			}
+		}
+		entry->next = head;
+	} while (!bucket.compare_exchange_weak(head, entry,
+										   std::memory_order_release,
+										   std::memory_order_acquire));
+	return *entry;
+}
+
+bool InProcessStore::read(const std::string& key, const std::string* field,
+						  std::string& value) const {
+	const Entry* entry =
+		find(field ? FIELD_ENTRY : STRING_ENTRY, key, field ? *field : key);
+	if (!entry) return false;
+
+	for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+		const uint64_t sequence =
+			entry->sequence.load(std::memory_order_acquire);
+		// the writer may have been preempted in the middle of the write
+		if (sequence & 1) {
+			std::this_thread::yield();
+			continue;
+		}
+		const bool present = entry->present.load(std::memory_order_relaxed);
+		Buffer* buffer = entry->buffer.load(std::memory_order_relaxed);
+		// the size and buffer of a read overlapping a write may not match,
+		// the read is then discarded but must stay within the buffer
+		const size_t size = std::min(
+			entry->size.load(std::memory_order_relaxed),
+			buffer ? buffer->capacity : 0);
+		if (present) {
+			value.assign(buffer ? buffer->data() : "", size);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (entry->sequence.load(std::memory_order_relaxed) == sequence) {
+			return present;
+		}
+		std::this_thread::yield();
+	}
+	throw std::runtime_error(
+		"InProcessStore: Could not read a value, it is rewritten during every "
+		"copy.");
+}
+
+bool InProcessStore::write(const std::string& key, const std::string* field,
+						   const char* value, const size_t len,
+						   const bool only_if_absent) {
+	Entry& entry = findOrInsert(field ? FIELD_ENTRY : STRING_ENTRY, key,
+								field ? *field : key);
+	std::lock_guard<std::mutex> lock(entry.mutex);
+	const bool was_present = entry.present.load(std::memory_order_relaxed);
+	if (only_if_absent && was_present) return false;
+
+	const uint64_t sequence = entry.sequence.load(std::memory_order_relaxed);
+	entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Buffer* buffer = entry.buffer.load(std::memory_order_relaxed);
+	if (!buffer || buffer->capacity < len) {
+		const size_t capacity =
+			std::max(len, 2 * (buffer ? buffer->capacity : 8));
+		buffer =
+			static_cast<Buffer*>(::operator new(sizeof(Buffer) + capacity));
+		buffer->capacity = capacity;
+		entry.buffers.push_back(buffer);
+		entry.buffer.store(buffer, std::memory_order_relaxed);
+	}
+	memcpy(buffer->data(), value, len);
+	entry.size.store(len, std::memory_order_relaxed);
+	entry.present.store(true, std::memory_order_relaxed);
+
+	entry.sequence.store(sequence + 2, std::memory_order_release);
+
+	if (entry.hash && !was_present) entry.hash->num_fields.fetch_add(1);
+	return !was_present;
+}
+
+bool InProcessStore::clear(Entry& entry) {
+	if (!entry.present.load(std::memory_order_relaxed)) return false;
+	const uint64_t sequence = entry.sequence.load(std::memory_order_relaxed);
+	entry.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	entry.present.store(false, std::memory_order_relaxed);
+	entry.sequence.store(sequence + 2, std::memory_order_release);
+	return true;
+}
+
+bool InProcessStore::remove(const std::string& key) {
+	bool removed = false;
+	if (const Entry* found = find(STRING_ENTRY, key, key)) {
+		Entry& entry = const_cast<Entry&>(*found);
+		std::lock_guard<std::mutex> lock(entry.mutex);
+		removed = clear(entry);
+	}
+
+	// the hash mutex holds back the insertion of new fields while its field
+	// list is walked
+	if (const Entry* found = find(HASH_ENTRY, key, key)) {
+		Entry& hash = const_cast<Entry&>(*found);
+		std::lock_guard<std::mutex> hash_lock(hash.mutex);
+		for (Entry* field = hash.fields.load(std::memory_order_acquire); field;
+			 field = field->next_field) {
+			std::lock_guard<std::mutex> lock(field->mutex);
+			if (clear(*field)) {
+				hash.num_fields.fetch_sub(1);
+				removed = true;
+			}
+		}
+	}
+	return removed;
+}
+
+bool InProcessStore::exists(const std::string& key) const {
+	const Entry* entry = find(STRING_ENTRY, key, key);
+	if (entry && entry->present.load()) return true;
+	const Entry* hash = find(HASH_ENTRY, key, key);
+	return hash && hash->num_fields.load() > 0;
+}
+
+InProcessTransport::InProcessTransport(const std::string& endpoint_name)
+	: StoreTransport(InProcessStore::endpoint(endpoint_name),
+					 "inprocess://" + endpoint_name) {}
+
+}  // namespace SaiCommon
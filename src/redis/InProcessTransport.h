@@ -0,0 +1,125 @@
+#ifndef IN_PROCESS_TRANSPORT_H
+#define IN_PROCESS_TRANSPORT_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "StoreTransport.h"
+
+namespace SaiCommon {
+
+/**
+ * @brief Key-value store shared by the clients of a process connected to the
+ * same in-process endpoint. Holds string keys and hash fields.
+ *
+ * @details Reads take no lock: the entries are never removed from the hash
+ * table (a deleted key is only marked absent), and each value is protected
+ * by a sequence counter that readers check to retry a read overlapping a
+ * write, yielding between the retries and failing after a bounded number
+ * of them. A writer only locks the entry it writes, so the writes of
+ * different keys run in parallel, and new entries are pushed on their bucket
+ * without any lock. Each hash lists its fields, which a deletion of the
+ * hash walks. The buffers replaced when a value grows are kept until the
+ * store is destroyed, so a reader never touches freed memory.
+ */
+class InProcessStore : public KeyValueStore {
+public:
+	InProcessStore();
+	~InProcessStore() override;
+
+	// disallow copy and assign
+	InProcessStore(const InProcessStore&) = delete;
+	InProcessStore& operator=(const InProcessStore&) = delete;
+
+	/**
+	 * @brief Get the store of an endpoint, created on the first call. The
+	 * store lives as long as a transport uses it, the keys of an endpoint
+	 * are lost once all its clients are disconnected.
+	 *
+	 * @param name  name of the endpoint
+	 */
+	static std::shared_ptr<InProcessStore> endpoint(const std::string& name);
+
+	bool read(const std::string& key, const std::string* field,
+			  std::string& value) const override;
+	bool write(const std::string& key, const std::string* field,
+			   const char* value, const size_t len,
+			   const bool only_if_absent = false) override;
+	bool remove(const std::string& key) override;
+	bool exists(const std::string& key) const override;
+
+private:
+	// value buffer, its capacity fixed at allocation
+	struct Buffer {
+		size_t capacity;
+		char* data() { return reinterpret_cast<char*>(this + 1); }
+	};
+
+	// a string key, a field of a hash, or a hash key counting its fields
+	enum EntryType { STRING_ENTRY, FIELD_ENTRY, HASH_ENTRY };
+
+	struct Entry {
+		EntryType type;
+		std::string key;
+		std::string field;
+		// next entry of the bucket, set before the entry is published
+		Entry* next = nullptr;
+
+		// held by the writers of the value, and of the field list of a hash
+		std::mutex mutex;
+		// odd while the value is written
+		std::atomic<uint64_t> sequence{0};
+		std::atomic<Buffer*> buffer{nullptr};
+		std::atomic<size_t> size{0};
+		std::atomic<bool> present{false};
+		// all the buffers of the entry, written under its mutex
+		std::vector<Buffer*> buffers;
+
+		// fields of a hash entry, linked by next_field and only prepended
+		// (under the hash mutex), and the number of present ones
+		std::atomic<Entry*> fields{nullptr};
+		Entry* next_field = nullptr;
+		std::atomic<size_t> num_fields{0};
+		// hash entry of a field entry
+		Entry* hash = nullptr;
+	};
+
+	static constexpr size_t NUM_BUCKETS = 1 << 14;
+
+	static size_t bucketIndex(const EntryType type, const std::string& key,
+							  const std::string& field);
+
+	const Entry* find(const EntryType type, const std::string& key,
+					  const std::string& field) const;
+
+	// find or insert an entry. A field entry is inserted with the mutex of
+	// its hash entry held, inserting the hash entry if needed.
+	Entry& findOrInsert(const EntryType type, const std::string& key,
+						const std::string& field);
+
+	// mark an entry absent, with its mutex held. Returns false if it already
+	// was.
+	static bool clear(Entry& entry);
+
+	std::array<std::atomic<Entry*>, NUM_BUCKETS> _buckets;
+};
+
+/**
+ * @brief Transport exchanging values with the other clients of the same
+ * process through an InProcessStore, without any server or socket.
+ */
+class InProcessTransport : public StoreTransport {
+public:
+	/**
+	 * @brief Open the endpoint of the given name
+	 */
+	explicit InProcessTransport(const std::string& endpoint_name);
+};
+
+}  // namespace SaiCommon
+
+#endif	// IN_PROCESS_TRANSPORT_H
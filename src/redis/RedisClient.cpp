@@ -8,24 +8,85 @@
 
 #include "RedisClient.h"
 
+#include <poll.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 using namespace std;
 
 namespace SaiCommon {
 
+RedisClient::RedisClient() = default;
+
 RedisClient::RedisClient(const std::string& key_namespace_prefix) {
 		if(!key_namespace_prefix.empty()) {
 			_prefix = key_namespace_prefix + "::";
 		}
 	}
 
-void RedisClient::connect(const std::string& hostname, const int port,
-						  const struct timeval& timeout) {
-	// Connect to new server
-	_context.reset(nullptr);
-	redisContext* c = redisConnectWithTimeout(hostname.c_str(), port, timeout);
+// prefix of the hostname selecting a unix domain socket connection
+static const std::string UNIX_SOCKET_URI_PREFIX = "unix://";
+
+// prefix of the keyspace notification channels (database 0)
+static const std::string KEYSPACE_CHANNEL_PREFIX = "__keyspace@0__:";
+
+// channel of the client tracking invalidation messages
+static const std::string TRACKING_INVALIDATION_CHANNEL = "__redis__:invalidate";
+
+// prefix of the hostname selecting an in-process endpoint
+static const std::string IN_PROCESS_URI_PREFIX = "inprocess://";
+
+// fields of the history stream entries holding the sequence number and time
+// of a sample, next to the keys of the group (which cannot use these names)
+static const std::string HISTORY_SEQUENCE_FIELD = "__seq";
+static const std::string HISTORY_TIME_FIELD = "__time";
+
+static bool isHistoryField(const std::string& key) {
+	return key == HISTORY_SEQUENCE_FIELD || key == HISTORY_TIME_FIELD;
+}
+
+static bool isUnixSocketUri(const std::string& hostname) {
+	return hostname.compare(0, UNIX_SOCKET_URI_PREFIX.size(),
+							UNIX_SOCKET_URI_PREFIX) == 0;
+}
+
+// prefix of the hostname selecting a shared memory store
+static const std::string SHARED_MEMORY_URI_PREFIX = "shm://";
+
+static bool isInProcessUri(const std::string& hostname) {
+	return hostname.compare(0, IN_PROCESS_URI_PREFIX.size(),
+							IN_PROCESS_URI_PREFIX) == 0;
+}
+
+static bool isSharedMemoryUri(const std::string& hostname) {
+	return hostname.compare(0, SHARED_MEMORY_URI_PREFIX.size(),
+							SHARED_MEMORY_URI_PREFIX) == 0;
+}
+
+// open a blocking connection to a server given by its address and port, or
+// by "unix://<socket path>"
+static redisContext* connectToServer(const std::string& hostname,
+									 const int port,
+									 const struct timeval& timeout) {
+	if (isUnixSocketUri(hostname)) {
+		return redisConnectUnixWithTimeout(
+			hostname.substr(UNIX_SOCKET_URI_PREFIX.size()).c_str(), timeout);
+	}
+	return redisConnectWithTimeout(hostname.c_str(), port, timeout);
+}
+
+// transport over a new connection to a server, checked to be connected
+static std::unique_ptr<RedisTransport> serverTransport(redisContext* c) {
 	std::unique_ptr<redisContext, redisContextDeleter> context(c);
 
 	// Check for errors
@@ -37,58 +98,549 @@ void RedisClient::connect(const std::string& hostname, const int port,
 			"RedisClient: Could not connect to redis server: " +
 			std::string(context->errstr));
 
-	// Save context
-	_context = std::move(context);
+	return std::unique_ptr<RedisTransport>(
+		new RedisServerTransport(context.release()));
+}
+
+// monotonic time in nanoseconds, for the latency counters
+static uint64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   std::chrono::steady_clock::now().time_since_epoch())
+		.count();
+}
+
+// size of the arguments of a command, without the command name
+static size_t argumentBytes(const std::vector<size_t>& argvlen) {
+	size_t num_bytes = 0;
+	for (size_t i = 1; i < argvlen.size(); ++i) num_bytes += argvlen[i];
+	return num_bytes;
+}
+
+// add the keyspace events of the string and hash commands to the server
+// notify-keyspace-events setting if they are not enabled
+static void enableKeyspaceNotifications(redisContext* context) {
+	// keep the current server settings
+	std::unique_ptr<redisReply, redisReplyDeleter> reply(
+		(redisReply*)redisCommand(context,
+								  "CONFIG GET notify-keyspace-events"));
+	if (!reply || reply->type != REDIS_REPLY_ARRAY || reply->elements != 2 ||
+		reply->element[1]->type != REDIS_REPLY_STRING) {
+		throw std::runtime_error(
+			"RedisClient: Could not read the notify-keyspace-events server "
+			"setting (set it to 'K$h' in the server config to use "
+			"subscriptions).");
+	}
+	std::string flags(reply->element[1]->str, reply->element[1]->len);
+	const bool has_all = flags.find('A') != std::string::npos;
+	const bool has_keyspace = flags.find('K') != std::string::npos;
+	const bool has_strings = has_all || flags.find('$') != std::string::npos;
+	const bool has_hashes = has_all || flags.find('h') != std::string::npos;
+	if (has_keyspace && has_strings && has_hashes) return;
+
+	if (!has_keyspace) flags += "K";
+	if (!has_strings) flags += "$";
+	if (!has_hashes) flags += "h";
+	reply.reset((redisReply*)redisCommand(
+		context, "CONFIG SET notify-keyspace-events %s", flags.c_str()));
+	if (!reply || reply->type == REDIS_REPLY_ERROR) {
+		throw std::runtime_error(
+			"RedisClient: Could not enable keyspace notifications on the "
+			"server (set notify-keyspace-events to 'K$h' in the server "
+			"config).");
+	}
+}
+
+// subscribe a subscription connection to channels and wait for the
+// confirmations, so that no change after the call is missed. The messages
+// received in between are passed to handle_message, or dropped if it is
+// empty. Returns false if the connection failed.
+static bool subscribe(
+	redisContext* context, const std::vector<std::string>& channels,
+	const std::function<void(const redisReply*)>& handle_message) {
+	for (const auto& channel : channels) {
+		redisAppendCommand(context, "SUBSCRIBE %b", channel.data(),
+						   channel.size());
+	}
+	size_t num_confirmations = 0;
+	while (num_confirmations < channels.size()) {
+		redisReply* r;
+		if (redisGetReply(context, (void**)&r) == REDIS_ERR) return false;
+		std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
+		if (reply->type == REDIS_REPLY_ARRAY && reply->elements == 3 &&
+			reply->element[0]->type == REDIS_REPLY_STRING &&
+			std::strcmp(reply->element[0]->str, "subscribe") == 0) {
+			++num_confirmations;
+		} else if (handle_message) {
+			handle_message(reply.get());
+		}
+	}
+	return true;
+}
+
+// background reconnection: the thread waits for a request, then tries to
+// open and check a new connection (and subscription connection if needed)
+// and to replay the client state on them until it succeeds, sleeping
+// between the attempts. The connections are handed over to the client
+// through ready, the client never waits for the thread nor for the server.
+struct RedisClient::Reconnector {
+	// state of the client restored on the new connections before they are
+	// handed over, built by the client when the connection is lost
+	struct Replay {
+		// SET NX and HSETNX commands setting the receive keys that the
+		// server lost back to their last received values
+		std::vector<std::vector<std::string>> commands;
+		// channels of the subscription connection, opened if not empty
+		std::vector<std::string> channels;
+		bool keyspace_notifications = false;
+		bool client_tracking = false;
+	};
+
+	// settings of the connections to open and state to replay, set by the
+	// client with the request
+	std::string hostname;
+	int port = 0;
+	struct timeval timeout = {1, 500000};
+	struct timeval command_timeout = {0, 100000};
+	std::chrono::milliseconds max_backoff{1000};
+	Replay replay;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool requested = false;
+	bool stop = false;
+
+	// new connections, owned by the client once ready is set, and the error
+	// of the replay other than a lost connection, thrown by the client when
+	// it takes them
+	std::unique_ptr<redisContext, redisContextDeleter> context;
+	std::unique_ptr<redisContext, redisContextDeleter> subscription_context;
+	long long subscription_client_id = 0;
+	std::string replay_error;
+	std::atomic<bool> ready{false};
+
+	std::thread thread;
+
+	Reconnector() : thread(&Reconnector::run, this) {}
+
+	~Reconnector() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stop = true;
+		}
+		condition.notify_one();
+		thread.join();
+	}
+
+	void run();
+
+	// open a connection answering PING, or return nullptr
+	static redisContext* open(const std::string& hostname, const int port,
+							  const struct timeval& timeout,
+							  const struct timeval& command_timeout);
+
+	// restore the client state on new connections. Returns false if a
+	// connection failed, and sets error for the other failures.
+	static bool restore(const Replay& replay, redisContext* context,
+						redisContext* subscription_context,
+						const long long subscription_client_id,
+						std::string& error);
+};
+
+redisContext* RedisClient::Reconnector::open(
+	const std::string& hostname, const int port, const struct timeval& timeout,
+	const struct timeval& command_timeout) {
+	std::unique_ptr<redisContext, redisContextDeleter> context(
+		connectToServer(hostname, port, timeout));
+	if (!context || context->err ||
+		redisSetTimeout(context.get(), command_timeout) != REDIS_OK) {
+		return nullptr;
+	}
+	// a server still loading its data accepts connections but replies with
+	// errors
+	std::unique_ptr<redisReply, redisReplyDeleter> reply(
+		(redisReply*)redisCommand(context.get(), "PING"));
+	if (!reply || reply->type == REDIS_REPLY_ERROR) return nullptr;
+	return context.release();
+}
+
+bool RedisClient::Reconnector::restore(const Replay& replay,
+									   redisContext* context,
+									   redisContext* subscription_context,
+									   const long long subscription_client_id,
+									   std::string& error) {
+	// existing keys are left untouched, the error replies are ignored
+	std::vector<const char*> argv;
+	std::vector<size_t> argvlen;
+	for (const auto& command : replay.commands) {
+		argv.clear();
+		argvlen.clear();
+		for (const auto& argument : command) {
+			argv.push_back(argument.data());
+			argvlen.push_back(argument.size());
+		}
+		redisAppendCommandArgv(context, argv.size(), argv.data(),
+							   argvlen.data());
+	}
+	for (size_t i = 0; i < replay.commands.size(); ++i) {
+		redisReply* reply;
+		if (redisGetReply(context, (void**)&reply) != REDIS_OK) return false;
+		freeReplyObject(reply);
+	}
+
+	if (replay.keyspace_notifications) {
+		try {
+			enableKeyspaceNotifications(context);
+		} catch (const std::runtime_error& e) {
+			if (context->err) return false;
+			error = e.what();
+			return true;
+		}
+	}
+	// the messages received before the confirmations are dropped, the
+	// client fetches all the subscribed groups after the reconnection
+	if (!replay.channels.empty() &&
+		!subscribe(subscription_context, replay.channels, nullptr)) {
+		return false;
+	}
+	if (replay.client_tracking) {
+		std::unique_ptr<redisReply, redisReplyDeleter> reply(
+			(redisReply*)redisCommand(context,
+									  "CLIENT TRACKING on REDIRECT %lld",
+									  subscription_client_id));
+		if (!reply) return false;
+		if (reply->type == REDIS_REPLY_ERROR) {
+			error = "RedisClient: CLIENT TRACKING failed.";
+		}
+	}
+	return true;
+}
+
+void RedisClient::Reconnector::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		condition.wait(lock, [this] { return stop || requested; });
+		if (stop) return;
+
+		std::chrono::milliseconds backoff(10);
+		while (!stop && requested) {
+			const std::string attempt_hostname = hostname;
+			const int attempt_port = port;
+			const struct timeval attempt_timeout = timeout;
+			const struct timeval attempt_command_timeout = command_timeout;
+			const Replay attempt_replay = replay;
+			lock.unlock();
+
+			// connecting and replaying block up to the timeouts, outside of
+			// the lock
+			std::unique_ptr<redisContext, redisContextDeleter> new_context(
+				open(attempt_hostname, attempt_port, attempt_timeout,
+					 attempt_command_timeout));
+			std::unique_ptr<redisContext, redisContextDeleter>
+				new_subscription_context;
+			long long new_subscription_client_id = 0;
+			bool success = new_context != nullptr;
+			if (success && !attempt_replay.channels.empty()) {
+				new_subscription_context.reset(
+					open(attempt_hostname, attempt_port, attempt_timeout,
+						 attempt_command_timeout));
+				// the id is needed to redirect the tracking invalidations,
+				// and can only be asked before subscribing
+				std::unique_ptr<redisReply, redisReplyDeleter> reply;
+				if (new_subscription_context) {
+					reply.reset((redisReply*)redisCommand(
+						new_subscription_context.get(), "CLIENT ID"));
+				}
+				success = reply && reply->type == REDIS_REPLY_INTEGER;
+				if (success) new_subscription_client_id = reply->integer;
+			}
+			std::string error;
+			if (success) {
+				success = restore(attempt_replay, new_context.get(),
+								  new_subscription_context.get(),
+								  new_subscription_client_id, error);
+			}
+
+			lock.lock();
+			if (success) {
+				if (requested && !stop) {
+					context = std::move(new_context);
+					subscription_context = std::move(new_subscription_context);
+					subscription_client_id = new_subscription_client_id;
+					replay_error = std::move(error);
+					requested = false;
+					ready.store(true, std::memory_order_release);
+				}
+				break;
+			}
+			condition.wait_for(lock, backoff,
+							   [this] { return stop || !requested; });
+			backoff = std::min(2 * backoff, max_backoff);
+		}
+	}
+}
+
+RedisClient::~RedisClient() = default;
+
+void RedisClient::enableAutoReconnect(const int max_backoff_ms,
+									  const struct timeval& command_timeout) {
+	if (!_transport) {
+		throw std::runtime_error(
+			"RedisClient: connect() must be called before "
+			"enableAutoReconnect().");
+	}
+	requireServer("Automatic reconnection");
+	if (!_reconnector) _reconnector.reset(new Reconnector());
+	{
+		std::lock_guard<std::mutex> lock(_reconnector->mutex);
+		_reconnector->command_timeout = command_timeout;
+		_reconnector->max_backoff = std::chrono::milliseconds(max_backoff_ms);
+	}
+	redisSetTimeout(_transport->context(), command_timeout);
+	if (_subscription_context) {
+		redisSetTimeout(_subscription_context.get(), command_timeout);
+	}
+}
+
+bool RedisClient::connectionReady() {
+	if (!_connection_lost) return true;
+	if (!_reconnector->ready.load(std::memory_order_acquire)) return false;
+
+	// the thread is done with the new connections, the lock is not contended
+	std::string error;
+	{
+		std::lock_guard<std::mutex> lock(_reconnector->mutex);
+		_transport.reset(
+			new RedisServerTransport(_reconnector->context.release()));
+		_subscription_context = std::move(_reconnector->subscription_context);
+		_subscription_client_id = _reconnector->subscription_client_id;
+		error.swap(_reconnector->replay_error);
+		_reconnector->ready.store(false, std::memory_order_relaxed);
+	}
+	_connection_lost = false;
+
+	// the changes during the disconnection were missed
+	for (auto& group : _receive_groups) {
+		if (group.subscribed) group.has_new_data = true;
+		if (group.cache) group.cache->stale.clear();
+	}
+	if (!error.empty()) throw std::runtime_error(error);
+	return true;
+}
+
+void RedisClient::connectionLost() {
+	_connection_lost = true;
+	// the values may have been only partially sent, send them all next time
+	for (auto& group : _send_groups) {
+		if (!group.plan) continue;
+		for (auto& last_sent : group.plan->last_sent) last_sent.sent = false;
+	}
+	for (auto& plan : _send_plans) {
+		for (auto& last_sent : plan->last_sent) last_sent.sent = false;
+	}
+	for (auto& group_list : _send_group_lists) {
+		if (!group_list.plan) continue;
+		for (auto& last_sent : group_list.plan->last_sent) {
+			last_sent.sent = false;
+		}
+	}
+
+	// the state restored by the reconnector. The receive keys that the
+	// server lost are set back to the last received values, so that
+	// receiving before the senders are back keeps them.
+	Reconnector::Replay replay;
+	std::string value;
+	for (const auto& group : _receive_groups) {
+		if (!group.in_use || !group.packed_key.empty()) continue;
+		for (size_t i = 0; i < group.keys.size(); ++i) {
+			// the registered objects of a buffered group belong to the reading
+			// thread
+			const ReceiveObject& object = group.snapshots
+											  ? group.snapshots->staging[i]
+											  : group.objects[i];
+			value.clear();
+			object.codec->encode(object.object,
+								 eigenEncodingForKey(group.keys[i]),
+								 _double_precision, value);
+			if (group.hash_key.empty()) {
+				replay.commands.push_back(
+					{"SET", _prefix + group.keys[i], value, "NX"});
+			} else {
+				replay.commands.push_back({"HSETNX", _prefix + group.hash_key,
+										   group.keys[i], value});
+			}
+		}
+	}
+	for (const auto& channel_groups : _keyspace_channel_groups) {
+		replay.channels.push_back(channel_groups.first);
+	}
+	replay.keyspace_notifications = !replay.channels.empty();
+	if (_client_tracking_enabled) {
+		replay.channels.push_back(TRACKING_INVALIDATION_CHANNEL);
+		replay.client_tracking = true;
+	}
+
+	std::lock_guard<std::mutex> lock(_reconnector->mutex);
+	_reconnector->hostname = _hostname;
+	_reconnector->port = _port;
+	_reconnector->timeout = _timeout;
+	_reconnector->replay = std::move(replay);
+	_reconnector->requested = true;
+	_reconnector->condition.notify_one();
+}
+
+void RedisClient::connect(const std::string& hostname, const int port,
+						  const struct timeval& timeout) {
+	// Connect to new server
+	std::unique_ptr<RedisTransport> transport;
+	if (isInProcessUri(hostname)) {
+		transport.reset(new InProcessTransport(
+			hostname.substr(IN_PROCESS_URI_PREFIX.size())));
+	} else if (isSharedMemoryUri(hostname)) {
+		// the store of the key namespace by default
+		std::string name = hostname.substr(SHARED_MEMORY_URI_PREFIX.size());
+		if (name.empty()) {
+			name = _prefix.empty() ? "default"
+								   : _prefix.substr(0, _prefix.size() - 2);
+		}
+		transport.reset(new SharedMemoryTransport(name));
+	} else {
+		transport = serverTransport(connectToServer(hostname, port, timeout));
+	}
+	connect(std::move(transport));
+
+	// remember the server for the additional connections
+	_hostname = hostname;
+	_port = port;
+	_timeout = timeout;
+}
+
+void RedisClient::connect(std::unique_ptr<RedisTransport> transport) {
+	if (!transport) {
+		throw std::runtime_error(
+			"RedisClient: Cannot connect to a null transport.");
+	}
+
+	// a pending reconnection is replaced by this connection
+	if (_reconnector) {
+		std::lock_guard<std::mutex> lock(_reconnector->mutex);
+		_reconnector->requested = false;
+		_reconnector->ready.store(false, std::memory_order_relaxed);
+		_reconnector->context.reset(nullptr);
+		_reconnector->subscription_context.reset(nullptr);
+	}
+	_connection_lost = false;
+
+	// subscriptions and client tracking belong to the previous connection
+	_subscription_context.reset(nullptr);
+	for (auto& group : _receive_groups) {
+		group.subscribed = false;
+		group.has_new_data = false;
+		group.cache.reset();
+	}
+	_keyspace_channel_groups.clear();
+	_client_tracking_enabled = false;
+
+	_transport = std::move(transport);
 
 	// create default send and receive groups
 	createNewSendGroup("default");
 	createNewReceiveGroup("default");
 }
 
+void RedisClient::connectUnix(const std::string& socket_path,
+							  const struct timeval& timeout) {
+	connect(UNIX_SOCKET_URI_PREFIX + socket_path, 0, timeout);
+}
+
+void RedisClient::requireServer(const std::string& feature) const {
+	if (!_transport || !_transport->context()) {
+		throw std::runtime_error("RedisClient: " + feature +
+								 " needs a connection to a redis server, not "
+								 "available with " +
+								 (_transport ? _transport->description()
+											 : std::string("no connection")) +
+								 ".");
+	}
+}
+
 std::unique_ptr<redisReply, redisReplyDeleter> RedisClient::command(
 	const char* format, ...) {
+	char* formatted = nullptr;
 	va_list ap;
 	va_start(ap, format);
-	redisReply* reply = (redisReply*)redisvCommand(_context.get(), format, ap);
+	const int len = redisvFormatCommand(&formatted, format, ap);
 	va_end(ap);
+	if (len < 0) return nullptr;
+
+	const int status = _transport->appendFormattedCommand(formatted, len);
+	redisFreeCommand(formatted);
+	redisReply* reply = nullptr;
+	if (status != REDIS_OK || _transport->getReply(&reply) != REDIS_OK) {
+		return nullptr;
+	}
+	return std::unique_ptr<redisReply, redisReplyDeleter>(reply);
+}
+
+std::unique_ptr<redisReply, redisReplyDeleter> RedisClient::commandArgv(
+	const int argc, const char** argv, const size_t* argvlen) {
+	redisReply* reply = nullptr;
+	if (_transport->appendCommandArgv(argc, argv, argvlen) != REDIS_OK ||
+		_transport->getReply(&reply) != REDIS_OK) {
+		return nullptr;
+	}
 	return std::unique_ptr<redisReply, redisReplyDeleter>(reply);
 }
 
 void RedisClient::ping() {
 	auto reply = command("PING");
 	std::cout << std::endl
-			  << "RedisClient: PING " << _context->tcp.host << ":"
-			  << _context->tcp.port << std::endl;
+			  << "RedisClient: PING " << _transport->description() << std::endl;
 	if (!reply) throw std::runtime_error("RedisClient: PING failed.");
 	std::cout << "Reply: " << reply->str << std::endl << std::endl;
 }
 
 std::string RedisClient::get(const std::string& key) {
 	const std::string key_with_prefix = _prefix + key;
+	StatsCounters& stats = _command_stats[COMMAND_GET];
 	// Call GET command
+	const uint64_t start_ns = nowNs();
 	auto reply = command("GET %s", key_with_prefix.c_str());
+	const uint64_t latency_ns = nowNs() - start_ns;
 
 	// Check for errors
 	if (!reply || reply->type == REDIS_REPLY_ERROR ||
-		reply->type == REDIS_REPLY_NIL)
+		reply->type == REDIS_REPLY_NIL) {
+		stats.recordError();
 		throw std::runtime_error("RedisClient: GET '" + key_with_prefix + "' failed.");
-	if (reply->type != REDIS_REPLY_STRING)
+	}
+	if (reply->type != REDIS_REPLY_STRING) {
+		stats.recordError();
 		throw std::runtime_error("RedisClient: GET '" + key_with_prefix +
 								 "' returned non-string value.");
+	}
+	stats.recordCall(latency_ns, 1, key_with_prefix.size(), reply->len);
 
-	// Return value
-	return reply->str;
+	// Return value (binary safe)
+	return std::string(reply->str, reply->len);
 }
 
 void RedisClient::set(const std::string& key, const std::string& value) {
 	const std::string key_with_prefix = _prefix + key;
+	StatsCounters& stats = _command_stats[COMMAND_SET];
 	// Call SET command
-	auto reply = command("SET %s %s", key_with_prefix.c_str(), value.c_str());
+	const uint64_t start_ns = nowNs();
+	auto reply = command("SET %s %b", key_with_prefix.c_str(), value.data(),
+						 value.size());
+	const uint64_t latency_ns = nowNs() - start_ns;
 
 	// Check for errors
-	if (!reply || reply->type == REDIS_REPLY_ERROR)
+	if (!reply || reply->type == REDIS_REPLY_ERROR) {
+		stats.recordError();
 		throw std::runtime_error("RedisClient: SET '" + key_with_prefix + "' '" + value +
 								 "' failed.");
+	}
+	stats.recordCall(latency_ns, 1, key_with_prefix.size() + value.size(),
+					 replyBytes(reply.get()));
 }
 
 void RedisClient::del(const std::string& key) {
@@ -126,10 +678,17 @@ bool RedisClient::exists(const std::string& key) {
 
 std::vector<std::string> RedisClient::pipeget(
 	const std::vector<std::string>& keys) {
+	StatsCounters& stats = _command_stats[COMMAND_PIPEGET];
+	const uint64_t start_ns = nowNs();
+	size_t bytes_sent = 0, bytes_received = 0;
+
 	// Prepare key list
 	for (const auto& key : keys) {
 		const std::string key_with_prefix = _prefix + key;
-		redisAppendCommand(_context.get(), "GET %s", key_with_prefix.c_str());
+		const char* argv[] = {"GET", key_with_prefix.data()};
+		const size_t argvlen[] = {3, key_with_prefix.size()};
+		_transport->appendCommandArgv(2, argv, argvlen);
+		bytes_sent += key_with_prefix.size();
 	}
 
 	// Collect values
@@ -137,46 +696,81 @@ std::vector<std::string> RedisClient::pipeget(
 	for (const auto& key : keys) {
 		const std::string key_with_prefix = _prefix + key;
 		redisReply* r;
-		if (redisGetReply(_context.get(), (void**)&r) == REDIS_ERR)
+		if (_transport->getReply(&r) == REDIS_ERR) {
+			stats.recordError();
 			throw std::runtime_error(
 				"RedisClient: Pipeline GET command failed for key: " + key_with_prefix + ".");
+		}
 
 		std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
-		if (reply->type != REDIS_REPLY_STRING)
+		if (reply->type != REDIS_REPLY_STRING) {
+			stats.recordError();
 			throw std::runtime_error(
 				"RedisClient: Pipeline GET command returned non-string value for key: " +
 				key_with_prefix + ".");
+		}
 
-		values.push_back(reply->str);
+		values.emplace_back(reply->str, reply->len);
+		bytes_received += reply->len;
 	}
 
+	stats.recordCall(nowNs() - start_ns, keys.size(), bytes_sent,
+					 bytes_received);
 	return values;
 }
 
 void RedisClient::pipeset(
 	const std::vector<std::pair<std::string, std::string>>& keyvals) {
+	StatsCounters& stats = _command_stats[COMMAND_PIPESET];
+	const uint64_t start_ns = nowNs();
+	size_t bytes_sent = 0, bytes_received = 0;
+
 	// Prepare key list
 	for (const auto& keyval : keyvals) {
 		const std::string key_with_prefix = _prefix + keyval.first;
-		redisAppendCommand(_context.get(), "SET %s %s", key_with_prefix.c_str(),
-						   keyval.second.c_str());
+		const char* argv[] = {"SET", key_with_prefix.data(),
+							  keyval.second.data()};
+		const size_t argvlen[] = {3, key_with_prefix.size(),
+								  keyval.second.size()};
+		_transport->appendCommandArgv(3, argv, argvlen);
+		bytes_sent += key_with_prefix.size() + keyval.second.size();
 	}
 
 	for (const auto& keyval : keyvals) {
 		const std::string key_with_prefix = _prefix + keyval.first;
 		redisReply* r;
-		if (redisGetReply(_context.get(), (void**)&r) == REDIS_ERR)
+		if (_transport->getReply(&r) == REDIS_ERR) {
+			stats.recordError();
 			throw std::runtime_error(
 				"RedisClient: Pipeline SET command failed for key: " + key_with_prefix + ".");
+		}
 
 		std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
-		if (reply->type == REDIS_REPLY_ERROR)
+		if (reply->type == REDIS_REPLY_ERROR) {
+			stats.recordError();
 			throw std::runtime_error(
 				"RedisClient: Pipeline SET command failed for key: " + key_with_prefix + ".");
+		}
+		bytes_received += replyBytes(reply.get());
 	}
+
+	stats.recordCall(nowNs() - start_ns, keyvals.size(), bytes_sent,
+					 bytes_received);
 }
 
 std::vector<std::string> RedisClient::mget(
+	const std::vector<std::string>& keys) {
+	auto reply = mgetReply(keys);
+
+	// Collect values
+	std::vector<std::string> values;
+	for (size_t i = 0; i < reply->elements; i++) {
+		values.emplace_back(reply->element[i]->str, reply->element[i]->len);
+	}
+	return values;
+}
+
+std::unique_ptr<redisReply, redisReplyDeleter> RedisClient::mgetReply(
 	const std::vector<std::string>& keys) {
 	// Prepare key list
 	std::vector<const char*> argv = {"MGET"};
@@ -184,81 +778,175 @@ std::vector<std::string> RedisClient::mget(
 	for (const auto& key : keys) {
 		prefixed_keys.push_back(_prefix + key);
 	}
+	size_t bytes_sent = 0;
 	for (const auto& key : prefixed_keys) {
 		argv.push_back(key.c_str());
+		bytes_sent += key.size();
 	}
 
 	// Call MGET command with variable argument formatting
-	redisReply* r = (redisReply*)redisCommandArgv(_context.get(), argv.size(),
-												  &argv[0], nullptr);
-	std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
+	StatsCounters& stats = _command_stats[COMMAND_MGET];
+	const uint64_t start_ns = nowNs();
+	auto reply = commandArgv(argv.size(), &argv[0], nullptr);
+	const uint64_t latency_ns = nowNs() - start_ns;
 
 	// Check for errors
-	if (!reply || reply->type != REDIS_REPLY_ARRAY)
+	if (!reply || reply->type != REDIS_REPLY_ARRAY) {
+		stats.recordError();
 		throw std::runtime_error("RedisClient: MGET command failed.");
+	}
 
-	// Collect values
-	std::vector<std::string> values;
+	// Check values
 	for (size_t i = 0; i < reply->elements; i++) {
-		if (reply->element[i]->type != REDIS_REPLY_STRING)
+		if (reply->element[i]->type != REDIS_REPLY_STRING) {
+			stats.recordError();
 			throw std::runtime_error(
 				"RedisClient: MGET command returned non-string values.");
-
-		values.push_back(reply->element[i]->str);
+		}
 	}
-	return values;
+	stats.recordCall(latency_ns, keys.size(), bytes_sent,
+					 replyBytes(reply.get()));
+	return reply;
 }
 
 void RedisClient::mset(
 	const std::vector<std::pair<std::string, std::string>>& keyvals) {
-	// Prepare key-value list
+	// Prepare key-value list (with explicit lengths, values can be binary)
 	std::vector<const char*> argv = {"MSET"};
+	std::vector<size_t> argvlen = {4};
 	std::vector<std::string> prefixed_keys = {};
 	for (const auto& keyval : keyvals) {
 		prefixed_keys.push_back(_prefix + keyval.first);
 	}
 	for (size_t i = 0; i < keyvals.size(); i++) {
 		argv.push_back(prefixed_keys.at(i).c_str());
-		argv.push_back(keyvals.at(i).second.c_str());
+		argvlen.push_back(prefixed_keys.at(i).size());
+		argv.push_back(keyvals.at(i).second.data());
+		argvlen.push_back(keyvals.at(i).second.size());
 	}
 
 	// Call MSET command with variable argument formatting
-	redisReply* r = (redisReply*)redisCommandArgv(_context.get(), argv.size(),
-												  &argv[0], nullptr);
-	std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
+	StatsCounters& stats = _command_stats[COMMAND_MSET];
+	const uint64_t start_ns = nowNs();
+	auto reply = commandArgv(argv.size(), &argv[0], &argvlen[0]);
+	const uint64_t latency_ns = nowNs() - start_ns;
 
 	// Check for errors
-	if (!reply || reply->type == REDIS_REPLY_ERROR)
+	if (!reply || reply->type == REDIS_REPLY_ERROR) {
+		stats.recordError();
 		throw std::runtime_error("RedisClient: MSET command failed.");
+	}
+	stats.recordCall(latency_ns, keyvals.size(), argumentBytes(argvlen),
+					 replyBytes(reply.get()));
 }
 
-void RedisClient::createNewReceiveGroup(const std::string& group_name) {
+RedisClient::GroupHandle RedisClient::createNewReceiveGroup(
+	const std::string& group_name) {
 	if (receiveGroupExists(group_name)) {
 		cout << "receive group already exists with this name. Not creating a "
 				"new one"
 			 << endl;
-		return;
+		return receiveGroupHandle(group_name);
 	}
 
-	_receive_group_names.push_back(group_name);
-	_keys_to_receive[group_name] = vector<string>();
-	_objects_to_receive[group_name] = vector<void*>();
-	_objects_to_receive_types[group_name] = vector<RedisSupportedTypes>();
+	// reuse the slot of a deleted group if any
+	uint32_t index = 0;
+	while (index < _receive_groups.size() && _receive_groups[index].in_use) {
+		++index;
+	}
+	if (index == _receive_groups.size()) _receive_groups.emplace_back();
+	ReceiveGroup& group = _receive_groups[index];
+	group.name = group_name;
+	group.in_use = true;
+	_receive_group_indexes[group_name] = index;
+	return GroupHandle{index, group.generation};
 }
 
-void RedisClient::createNewSendGroup(const std::string& group_name) {
+RedisClient::GroupHandle RedisClient::createNewSendGroup(
+	const std::string& group_name) {
 	if (sendGroupExists(group_name)) {
 		cout << "send group already exists with this name. Not creating a new "
 				"one"
 			 << endl;
-		return;
+		return sendGroupHandle(group_name);
+	}
+
+	// reuse the slot of a deleted group if any
+	uint32_t index = 0;
+	while (index < _send_groups.size() && _send_groups[index].in_use) {
+		++index;
+	}
+	if (index == _send_groups.size()) _send_groups.emplace_back();
+	SendGroup& group = _send_groups[index];
+	group.name = group_name;
+	group.in_use = true;
+	_send_group_indexes[group_name] = index;
+	return GroupHandle{index, group.generation};
+}
+
+RedisClient::GroupHandle RedisClient::sendGroupHandle(
+	const std::string& group_name) const {
+	auto it = _send_group_indexes.find(group_name);
+	if (it == _send_group_indexes.end()) {
+		throw std::runtime_error("Send group with name [" + group_name +
+								 "] not found, cannot get its handle");
+	}
+	return GroupHandle{it->second, _send_groups[it->second].generation};
+}
+
+RedisClient::GroupHandle RedisClient::receiveGroupHandle(
+	const std::string& group_name) const {
+	auto it = _receive_group_indexes.find(group_name);
+	if (it == _receive_group_indexes.end()) {
+		throw std::runtime_error("Receive group with name [" + group_name +
+								 "] not found, cannot get its handle");
+	}
+	return GroupHandle{it->second, _receive_groups[it->second].generation};
+}
+
+static bool sameGroups(const std::vector<RedisClient::GroupHandle>& a,
+					   const std::vector<RedisClient::GroupHandle>& b) {
+	return a.size() == b.size() &&
+		   std::equal(a.begin(), a.end(), b.begin(),
+					  [](const RedisClient::GroupHandle& x,
+						 const RedisClient::GroupHandle& y) {
+						  return x.index == y.index &&
+								 x.generation == y.generation;
+					  });
+}
+
+RedisClient::GroupListHandle RedisClient::sendGroupListHandle(
+	const std::vector<GroupHandle>& groups) {
+	return GroupListHandle{sendGroupListIndex(groups)};
+}
+
+RedisClient::GroupListHandle RedisClient::receiveGroupListHandle(
+	const std::vector<GroupHandle>& groups) {
+	return GroupListHandle{receiveGroupListIndex(groups)};
+}
+
+uint32_t RedisClient::sendGroupListIndex(
+	const std::vector<GroupHandle>& groups) {
+	for (const GroupHandle& group : groups) {
+		sendGroup(group, "get the handle of a send group list");
+	}
+	for (size_t i = 0; i < _send_group_lists.size(); ++i) {
+		if (sameGroups(_send_group_lists[i].groups, groups)) return i;
 	}
+	_send_group_lists.push_back(SendGroupList{groups, nullptr});
+	return _send_group_lists.size() - 1;
+}
 
-	_send_group_names.push_back(group_name);
-	_keys_to_send[group_name] = vector<string>();
-	_objects_to_send[group_name] = vector<const void*>();
-	_objects_to_send_types[group_name] = vector<RedisSupportedTypes>();
-	_objects_to_send_sizes[group_name] = vector<pair<int, int>>();
+uint32_t RedisClient::receiveGroupListIndex(
+	const std::vector<GroupHandle>& groups) {
+	for (const GroupHandle& group : groups) {
+		receiveGroup(group, "get the handle of a receive group list");
+	}
+	for (size_t i = 0; i < _receive_group_lists.size(); ++i) {
+		if (sameGroups(_receive_group_lists[i].groups, groups)) return i;
+	}
+	_receive_group_lists.push_back(ReceiveGroupList{groups, nullptr});
+	return _receive_group_lists.size() - 1;
 }
 
 void RedisClient::deleteSendGroup(const std::string& group_name) {
@@ -268,13 +956,13 @@ void RedisClient::deleteSendGroup(const std::string& group_name) {
 		return;
 	}
 
-	_send_group_names.erase(std::remove(_send_group_names.begin(),
-										_send_group_names.end(), group_name),
-							_send_group_names.end());
-	_keys_to_send.erase(group_name);
-	_objects_to_send.erase(group_name);
-	_objects_to_send_types.erase(group_name);
-	_objects_to_send_sizes.erase(group_name);
+	// empty the slot, the handles to the group become invalid
+	const uint32_t index = _send_group_indexes.at(group_name);
+	const uint32_t generation = _send_groups[index].generation + 1;
+	_send_groups[index] = SendGroup();
+	_send_groups[index].generation = generation;
+	_send_group_indexes.erase(group_name);
+	clearSendPlans();
 }
 
 void RedisClient::deleteReceiveGroup(const std::string& group_name) {
@@ -284,299 +972,2319 @@ void RedisClient::deleteReceiveGroup(const std::string& group_name) {
 		return;
 	}
 
-	_receive_group_names.erase(
-		std::remove(_receive_group_names.begin(), _receive_group_names.end(),
-					group_name),
-		_receive_group_names.end());
-	_keys_to_receive.erase(group_name);
-	_objects_to_receive.erase(group_name);
-	_objects_to_receive_types.erase(group_name);
+	// empty the slot, the handles to the group become invalid
+	const uint32_t index = _receive_group_indexes.at(group_name);
+	const uint32_t generation = _receive_groups[index].generation + 1;
+	_receive_groups[index] = ReceiveGroup();
+	_receive_groups[index].generation = generation;
+	_receive_group_indexes.erase(group_name);
+	clearReceivePlans();
 }
 
 void RedisClient::addToReceiveGroup(const std::string& key, double& object,
 									const std::string& group_name) {
-	if (!receiveGroupExists(group_name)) {
-		throw std::runtime_error("Receive group with name [" + group_name +
-								 "] not found, cannot add object to "
-								 "receive");
-	}
-
-	setDouble(key, object);
-	_keys_to_receive[group_name].push_back(key);
-	_objects_to_receive[group_name].push_back(&object);
-	_objects_to_receive_types[group_name].push_back(DOUBLE_NUMBER);
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
 }
 
 void RedisClient::addToReceiveGroup(const std::string& key, std::string& object,
 									const std::string& group_name) {
-	if (!receiveGroupExists(group_name)) {
-		throw std::runtime_error("Receive group with name [" + group_name +
-								 "] not found, cannot add object to "
-								 "receive");
-	}
-
-	set(key, object);
-	_keys_to_receive[group_name].push_back(key);
-	_objects_to_receive[group_name].push_back(&object);
-	_objects_to_receive_types[group_name].push_back(STRING);
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
 }
 
 void RedisClient::addToReceiveGroup(const std::string& key, int& object,
 									const std::string& group_name) {
-	if (!receiveGroupExists(group_name)) {
-		throw std::runtime_error("Receive group with name [" + group_name +
-								 "] not found, cannot add object to "
-								 "receive");
-	}
-
-	setInt(key, object);
-	_keys_to_receive[group_name].push_back(key);
-	_objects_to_receive[group_name].push_back(&object);
-	_objects_to_receive_types[group_name].push_back(INT_NUMBER);
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
 }
 
 void RedisClient::addToReceiveGroup(const std::string& key, bool& object,
 									const std::string& group_name) {
-	if (!receiveGroupExists(group_name)) {
-		throw std::runtime_error("Receive group with name [" + group_name +
-								 "] not found, cannot add object to "
-								 "receive");
-	}
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, float& object,
+									const std::string& group_name) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, int64_t& object,
+									const std::string& group_name) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key,
+									std::vector<double>& object,
+									const std::string& group_name) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, double& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, std::string& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, int& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, bool& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
 
-	setBool(key, object);
-	_keys_to_receive[group_name].push_back(key);
-	_objects_to_receive[group_name].push_back(&object);
-	_objects_to_receive_types[group_name].push_back(BOOL);
+void RedisClient::addToReceiveGroup(const std::string& key, float& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key, int64_t& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+void RedisClient::addToReceiveGroup(const std::string& key,
+									std::vector<double>& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
 }
 
 void RedisClient::addToSendGroup(const std::string& key, const double& object,
 								 const std::string& group_name) {
-	if (!sendGroupExists(group_name)) {
-		throw std::runtime_error("Send group with name [" + group_name +
-								 "] not found, cannot add object to send");
-	}
-
-	_keys_to_send[group_name].push_back(key);
-	_objects_to_send[group_name].push_back(&object);
-	_objects_to_send_types[group_name].push_back(DOUBLE_NUMBER);
-	_objects_to_send_sizes[group_name].push_back(std::make_pair(0, 0));
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
 void RedisClient::addToSendGroup(const std::string& key,
 								 const std::string& object,
 								 const std::string& group_name) {
-	if (!sendGroupExists(group_name)) {
-		throw std::runtime_error("Send group with name [" + group_name +
-								 "] not found, cannot add object to send");
-	}
-
-	_keys_to_send[group_name].push_back(key);
-	_objects_to_send[group_name].push_back(&object);
-	_objects_to_send_types[group_name].push_back(STRING);
-	_objects_to_send_sizes[group_name].push_back(std::make_pair(0, 0));
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
 void RedisClient::addToSendGroup(const std::string& key, const int& object,
 								 const std::string& group_name) {
-	if (!sendGroupExists(group_name)) {
-		throw std::runtime_error("Send group with name [" + group_name +
-								 "] not found, cannot add object to send");
-	}
-
-	_keys_to_send[group_name].push_back(key);
-	_objects_to_send[group_name].push_back(&object);
-	_objects_to_send_types[group_name].push_back(INT_NUMBER);
-	_objects_to_send_sizes[group_name].push_back(std::make_pair(0, 0));
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
 void RedisClient::addToSendGroup(const std::string& key, const bool& object,
 								 const std::string& group_name) {
-	if (!sendGroupExists(group_name)) {
-		throw std::runtime_error("Send group with name [" + group_name +
-								 "] not found, cannot add object to send");
-	}
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
+}
 
-	_keys_to_send[group_name].push_back(key);
-	_objects_to_send[group_name].push_back(&object);
-	_objects_to_send_types[group_name].push_back(BOOL);
-	_objects_to_send_sizes[group_name].push_back(std::make_pair(0, 0));
+void RedisClient::addToSendGroup(const std::string& key, const float& object,
+								 const std::string& group_name) {
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
-void RedisClient::receiveAllFromGroup(const std::string& group_name) {
-	std::vector<std::string> group_names = {group_name};
-	receiveAllFromGroup(group_names);
+void RedisClient::addToSendGroup(const std::string& key, const int64_t& object,
+								 const std::string& group_name) {
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
-void RedisClient::receiveAllFromGroup(
-	const std::vector<std::string>& group_names) {
-	for (const auto& group_name : group_names) {
-		if (!receiveGroupExists(group_name)) {
-			throw std::runtime_error("Receive group with name [" + group_name +
-									 "] not found, cannot "
-									 "receiveAllFromGroup");
-		}
-	}
-
-	std::vector<std::string> keys_to_receive;
-	for (const auto& group_name : group_names) {
-		keys_to_receive.insert(keys_to_receive.end(),
-							   _keys_to_receive.at(group_name).begin(),
-							   _keys_to_receive.at(group_name).end());
-	}
-
-	std::vector<std::string> return_values = mget(keys_to_receive);
-	int return_values_index = 0;
-
-	for (const auto& group_name : group_names) {
-		for (int i = 0; i < _objects_to_receive.at(group_name).size(); ++i) {
-			switch (_objects_to_receive_types.at(group_name).at(i)) {
-				case DOUBLE_NUMBER: {
-					double* tmp_pointer =
-						(double*)_objects_to_receive.at(group_name).at(i);
-					*tmp_pointer = stod(return_values[return_values_index]);
-				} break;
-
-				case INT_NUMBER: {
-					int* tmp_pointer =
-						(int*)_objects_to_receive.at(group_name).at(i);
-					*tmp_pointer = stoi(return_values[return_values_index]);
-				} break;
-
-				case BOOL: {
-					bool* tmp_pointer =
-						(bool*)_objects_to_receive.at(group_name).at(i);
-					*tmp_pointer =
-						(bool)stoi(return_values[return_values_index]);
-				} break;
-
-				case STRING: {
-					std::string* tmp_pointer =
-						(std::string*)_objects_to_receive.at(group_name).at(i);
-					*tmp_pointer = return_values[return_values_index];
-				} break;
-
-				case EIGEN_OBJECT: {
-					double* tmp_pointer =
-						(double*)_objects_to_receive.at(group_name).at(i);
-
-					Eigen::MatrixXd tmp_return_matrix =
-						RedisClient::decodeEigenMatrix(
-							return_values[return_values_index]);
-
-					int nrows = tmp_return_matrix.rows();
-					int ncols = tmp_return_matrix.cols();
-
-					for (int k = 0; k < nrows; k++) {
-						for (int l = 0; l < ncols; l++) {
-							tmp_pointer[k + ncols * l] =
-								tmp_return_matrix(k, l);
-						}
-					}
-				} break;
-
-				default:
-					throw std::runtime_error(
-						"RedisClient: Unknown type in "
-						"receiveAllFromGroup");
-					break;
-			}
-			return_values_index++;
-		}
-	}
+void RedisClient::addToSendGroup(const std::string& key,
+								 const std::vector<double>& object,
+								 const std::string& group_name) {
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
-void RedisClient::sendAllFromGroup(const std::string& group_name) {
-	std::vector<std::string> group_names = {group_name};
-	sendAllFromGroup(group_names);
+void RedisClient::addToSendGroup(const std::string& key, const double& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
 }
 
-void RedisClient::sendAllFromGroup(
-	const std::vector<std::string>& group_names) {
-	for (const auto& group_name : group_names) {
-		if (!sendGroupExists(group_name)) {
-			throw std::runtime_error("Send group with name [" + group_name +
-									 "] not found, cannot sendAllFromGroup");
-		}
-	}
-
-	std::vector<std::pair<std::string, std::string>> write_key_value_pairs;
-
-	for (const auto& group_name : group_names) {
-		for (int i = 0; i < _keys_to_send.at(group_name).size(); i++) {
-			std::string encoded_value = "";
-
-			switch (_objects_to_send_types.at(group_name).at(i)) {
-				case DOUBLE_NUMBER: {
-					double* tmp_pointer =
-						(double*)_objects_to_send.at(group_name).at(i);
-					encoded_value = std::to_string(*tmp_pointer);
-				} break;
-
-				case INT_NUMBER: {
-					int* tmp_pointer =
-						(int*)_objects_to_send.at(group_name).at(i);
-					encoded_value = std::to_string(*tmp_pointer);
-				} break;
-
-				case BOOL: {
-					bool* tmp_pointer =
-						(bool*)_objects_to_send.at(group_name).at(i);
-					encoded_value = *tmp_pointer ? "1" : "0";
-				} break;
-
-				case STRING: {
-					std::string* tmp_pointer =
-						(std::string*)_objects_to_send.at(group_name).at(i);
-					encoded_value = (*tmp_pointer);
-				} break;
-
-				case EIGEN_OBJECT: {
-					double* tmp_pointer =
-						(double*)_objects_to_send.at(group_name).at(i);
-					int nrows =
-						_objects_to_send_sizes.at(group_name).at(i).first;
-					int ncols =
-						_objects_to_send_sizes.at(group_name).at(i).second;
-
-					Eigen::MatrixXd tmp_matrix =
-						Eigen::MatrixXd::Zero(nrows, ncols);
-					for (int k = 0; k < nrows; k++) {
-						for (int l = 0; l < ncols; l++) {
-							tmp_matrix(k, l) = tmp_pointer[k + ncols * l];
-						}
-					}
-
-					encoded_value = encodeEigenMatrix(tmp_matrix);
-				} break;
-			}
+void RedisClient::addToSendGroup(const std::string& key,
+								 const std::string& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
 
-			if (encoded_value != "") {
-				write_key_value_pairs.push_back(make_pair(
-					_keys_to_send.at(group_name).at(i), encoded_value));
-			}
-		}
-	}
+void RedisClient::addToSendGroup(const std::string& key, const int& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
 
-	mset(write_key_value_pairs);
+void RedisClient::addToSendGroup(const std::string& key, const bool& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
 }
 
-bool RedisClient::sendGroupExists(const std::string& group_name) const {
-	auto it = std::find(_send_group_names.begin(), _send_group_names.end(),
-						group_name);
-	return it != _send_group_names.end();
+void RedisClient::addToSendGroup(const std::string& key, const float& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
 }
 
-bool RedisClient::receiveGroupExists(const std::string& group_name) const {
-	auto it = std::find(_receive_group_names.begin(),
-						_receive_group_names.end(), group_name);
-	return it != _receive_group_names.end();
+void RedisClient::addToSendGroup(const std::string& key, const int64_t& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
 }
 
-static inline Eigen::MatrixXd decodeEigenMatrixWithDelimiters(
-	const std::string& str, char col_delimiter, char row_delimiter,
-	const std::string& delimiter_set, size_t idx_row_end = std::string::npos) {
-	// Count number of columns
-	size_t num_cols = 0;
+void RedisClient::addToSendGroup(const std::string& key,
+								 const std::vector<double>& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
+
+RedisClient::GroupStatus RedisClient::receiveAllFromGroup(
+	const std::string& group_name) {
+	ReceiveGroup& group = receiveGroup(group_name, "receiveAllFromGroup");
+	if (group.cache) return receiveCachedGroup(group);
+	return executeReceivePlan(*compiledReceivePlan(group));
+}
+
+RedisClient::GroupStatus RedisClient::receiveAllFromGroup(
+	const std::vector<std::string>& group_names) {
+	return executeReceivePlan(
+		*compiledReceivePlan(group_names.data(), group_names.size()));
+}
+
+RedisClient::GroupStatus RedisClient::receiveAllFromGroup(
+	const GroupHandle& group) {
+	ReceiveGroup& receive_group = receiveGroup(group, "receiveAllFromGroup");
+	if (receive_group.cache) return receiveCachedGroup(receive_group);
+	return executeReceivePlan(*compiledReceivePlan(receive_group));
+}
+
+RedisClient::GroupStatus RedisClient::receiveAllFromGroup(
+	const GroupListHandle& groups) {
+	return executeReceivePlan(
+		*compiledReceivePlan(groups, "receiveAllFromGroup"));
+}
+
+const std::shared_ptr<RedisClient::ReceivePlan>&
+RedisClient::compiledReceivePlan(const std::string* group_names,
+								 const size_t num_groups) {
+	// a single group has its own plan
+	if (num_groups == 1) {
+		return compiledReceivePlan(
+			receiveGroup(group_names[0], "receiveAllFromGroup"));
+	}
+
+	// reuse the plan compiled for that exact list of groups if any
+	for (const auto& plan : _receive_plans) {
+		if (plan->group_names.size() == num_groups &&
+			std::equal(plan->group_names.begin(), plan->group_names.end(),
+					   group_names)) {
+			return plan;
+		}
+	}
+
+	std::vector<ReceiveGroup*> groups;
+	for (size_t g = 0; g < num_groups; ++g) {
+		groups.push_back(&receiveGroup(group_names[g], "receiveAllFromGroup"));
+	}
+	_receive_plans.push_back(std::make_shared<ReceivePlan>(
+		compileReceivePlan(groups.data(), groups.size())));
+	_receive_plans.back()->stats =
+		groupStats(_receive_group_stats, group_names, num_groups);
+	return _receive_plans.back();
+}
+
+const std::shared_ptr<RedisClient::ReceivePlan>&
+RedisClient::compiledReceivePlan(ReceiveGroup& group) {
+	if (!group.plan) {
+		ReceiveGroup* groups[] = {&group};
+		group.plan = std::make_shared<ReceivePlan>(compileReceivePlan(groups, 1));
+		group.plan->stats = groupStats(_receive_group_stats, &group.name, 1);
+	}
+	return group.plan;
+}
+
+const std::shared_ptr<RedisClient::ReceivePlan>&
+RedisClient::compiledReceivePlan(const GroupListHandle& groups,
+								 const char* action) {
+	if (groups.index >= _receive_group_lists.size()) {
+		throw std::runtime_error(
+			"Receive group list handle is invalid, cannot " +
+			std::string(action));
+	}
+	ReceiveGroupList& group_list = _receive_group_lists[groups.index];
+	if (group_list.plan) return group_list.plan;
+
+	// a single group has its own plan
+	if (group_list.groups.size() == 1) {
+		return compiledReceivePlan(receiveGroup(group_list.groups[0], action));
+	}
+
+	// the plans are dropped when a group is deleted, so the handles are only
+	// checked when compiling
+	std::vector<ReceiveGroup*> receive_groups;
+	std::vector<std::string> group_names;
+	for (const GroupHandle& group : group_list.groups) {
+		receive_groups.push_back(&receiveGroup(group, action));
+		group_names.push_back(receive_groups.back()->name);
+	}
+	group_list.plan = std::make_shared<ReceivePlan>(
+		compileReceivePlan(receive_groups.data(), receive_groups.size()));
+	group_list.plan->stats = groupStats(
+		_receive_group_stats, group_names.data(), group_names.size());
+	return group_list.plan;
+}
+
+RedisClient::ReceivePlan RedisClient::compileReceivePlan(
+	ReceiveGroup* const* groups, const size_t num_groups) const {
+	// freeze the groups into a flat plan
+	ReceivePlan plan;
+	for (size_t g = 0; g < num_groups; ++g) {
+		const ReceiveGroup& receive_group = *groups[g];
+		const auto& keys = receive_group.keys;
+		plan.group_names.push_back(receive_group.name);
+
+		// a buffered group is decoded into its staging copies
+		const std::vector<ReceiveObject>& objects =
+			receive_group.snapshots ? receive_group.snapshots->staging
+									: receive_group.objects;
+		if (receive_group.snapshots) {
+			plan.snapshots.push_back(receive_group.snapshots);
+		}
+
+		if (!receive_group.packed_key.empty()) {
+			PackedReceiveGroup group;
+			group.prefixed_key = _prefix + receive_group.packed_key;
+			group.keys = keys;
+			group.objects = objects;
+			plan.packed_groups.push_back(std::move(group));
+			continue;
+		}
+
+		// the objects of a hash group are fields of its HMGET
+		HashReceiveCommand* hash_command = nullptr;
+		if (!receive_group.hash_key.empty() && !keys.empty()) {
+			plan.hash_commands.emplace_back();
+			hash_command = &plan.hash_commands.back();
+			hash_command->prefixed_key = _prefix + receive_group.hash_key;
+		}
+
+		for (size_t i = 0; i < keys.size(); ++i) {
+			const ReceiveObject& object = objects[i];
+			ReceiveDecoder decoder;
+			decoder.decode = object.codec->decode;
+			decoder.object = object.object;
+			if (hash_command) {
+				hash_command->fields.push_back(keys[i]);
+				hash_command->decoders.push_back(decoder);
+			} else {
+				plan.prefixed_keys.push_back(_prefix + keys[i]);
+				plan.decoders.push_back(decoder);
+			}
+		}
+	}
+
+	// cached MGET command
+	plan.argv.push_back("MGET");
+	plan.argvlen.push_back(4);
+	for (const auto& key : plan.prefixed_keys) {
+		plan.argv.push_back(key.data());
+		plan.argvlen.push_back(key.size());
+	}
+	for (const auto& group : plan.packed_groups) {
+		plan.argv.push_back(group.prefixed_key.data());
+		plan.argvlen.push_back(group.prefixed_key.size());
+	}
+
+	// cached HMGET commands
+	for (auto& command : plan.hash_commands) {
+		command.argv.assign({"HMGET", command.prefixed_key.data()});
+		command.argvlen.assign({5, command.prefixed_key.size()});
+		for (const auto& field : command.fields) {
+			command.argv.push_back(field.data());
+			command.argvlen.push_back(field.size());
+		}
+	}
+
+	return plan;
+}
+
+RedisClient::GroupStatus RedisClient::executeReceivePlan(ReceivePlan& plan) {
+	StatsCounters& stats = *plan.stats;
+	if (!connectionReady()) {
+		stats.recordError();
+		return GROUP_DISCONNECTED;
+	}
+	const uint64_t start_ns = nowNs();
+	size_t num_keys = 0, num_bytes = 0;
+	const size_t num_commands =
+		appendReceivePlanCommands(plan, num_keys, num_bytes);
+	if (num_commands == 0) return GROUP_OK;
+
+	if (!readPipelineReplies(num_commands)) {
+		stats.recordError();
+		if (_reconnector) {
+			connectionLost();
+			return GROUP_DISCONNECTED;
+		}
+		throw std::runtime_error("RedisClient: MGET command failed.");
+	}
+	const uint64_t received_ns = nowNs();
+	try {
+		decodeReceivePlanReplies(plan, 0);
+	} catch (...) {
+		stats.recordError();
+		throw;
+	}
+	stats.recordDecode(nowNs() - received_ns);
+	stats.recordCall(received_ns - start_ns, num_keys, num_bytes,
+					 pipelineReplyBytes());
+	return GROUP_OK;
+}
+
+void RedisClient::decodeReceivePlanReply(ReceivePlan& plan,
+										 const redisReply* reply) {
+	// Check for errors
+	if (!reply || reply->type != REDIS_REPLY_ARRAY ||
+		reply->elements != plan.argv.size() - 1)
+		throw std::runtime_error("RedisClient: MGET command failed.");
+
+	// decode straight from the reply buffers into the registered objects
+	for (size_t i = 0; i < plan.decoders.size(); ++i) {
+		const redisReply* value = reply->element[i];
+		if (value->type != REDIS_REPLY_STRING)
+			throw std::runtime_error(
+				"RedisClient: MGET command returned non-string values.");
+		const ReceiveDecoder& decoder = plan.decoders[i];
+		decoder.decode(value->str, value->len, decoder.object);
+	}
+
+	// then the packed groups
+	for (size_t p = 0; p < plan.packed_groups.size(); ++p) {
+		const redisReply* value = reply->element[plan.decoders.size() + p];
+		if (value->type != REDIS_REPLY_STRING)
+			throw std::runtime_error("RedisClient: packed group key '" +
+									 plan.packed_groups[p].prefixed_key +
+									 "' not found.");
+		unpackGroup(plan.packed_groups[p], value->str, value->len);
+	}
+}
+
+void RedisClient::unpackGroup(PackedReceiveGroup& group, const char* blob,
+							  const size_t len) {
+	using namespace RedisPackedGroup;
+	using RedisEigenBinary::readLittleEndian;
+
+	const std::string error_prefix =
+		"RedisClient: Failed to unpack group from key '" + group.prefixed_key +
+		"': ";
+	if (len < HEADER_SIZE || std::memcmp(blob, MAGIC, sizeof(MAGIC)) != 0 ||
+		(uint8_t)blob[4] != VERSION) {
+		throw std::runtime_error(error_prefix + "not a packed group.");
+	}
+	const uint32_t num_entries = readLittleEndian<uint32_t>(blob + 8);
+	const size_t schema_end =
+		HEADER_SIZE + readLittleEndian<uint32_t>(blob + 12);
+	// each schema entry takes at least 11 bytes, which bounds the number of
+	// entries before anything is sized from it
+	if (schema_end > len || num_entries > (schema_end - HEADER_SIZE) / 11) {
+		throw std::runtime_error(error_prefix + "truncated schema.");
+	}
+
+	// match the entries to the objects only when the schema changes
+	if (group.schema.size() != schema_end ||
+		std::memcmp(group.schema.data(), blob, schema_end) != 0) {
+		group.schema.clear();
+		group.entry_objects.assign(num_entries, -1);
+		std::vector<bool> found(group.keys.size(), false);
+		const char* p = blob + HEADER_SIZE;
+		for (uint32_t e = 0; e < num_entries; ++e) {
+			if (p + 2 > blob + schema_end) {
+				throw std::runtime_error(error_prefix + "truncated schema.");
+			}
+			const uint16_t name_len = readLittleEndian<uint16_t>(p);
+			if (p + 2 + name_len + 9 > blob + schema_end) {
+				throw std::runtime_error(error_prefix + "truncated schema.");
+			}
+			const std::string name(p + 2, name_len);
+			p += 2 + name_len;
+			const uint8_t type = (uint8_t)p[0];
+			const uint32_t rows = readLittleEndian<uint32_t>(p + 1);
+			const uint32_t cols = readLittleEndian<uint32_t>(p + 5);
+			p += 9;
+			// a shape larger than the values cannot be valid
+			if (type == EIGEN_FLOAT64 &&
+				(rows > (uint32_t)std::numeric_limits<int>::max() ||
+				 cols > (uint32_t)std::numeric_limits<int>::max() ||
+				 (cols != 0 &&
+				  rows > (len - schema_end) / sizeof(double) / cols))) {
+				throw std::runtime_error(error_prefix + "entry '" + name +
+										 "' is larger than the group.");
+			}
+
+			auto it = std::find(group.keys.begin(), group.keys.end(), name);
+			if (it == group.keys.end()) continue;
+			const size_t i = it - group.keys.begin();
+
+			// the objects of dynamic size are resized here, since a change
+			// of shape is a change of schema
+			const ReceiveObject& object = group.objects[i];
+			const bool compatible =
+				type == object.codec->packed_type &&
+				(type != EIGEN_FLOAT64 ||
+				 object.codec->reshape(object.object, rows, cols));
+			if (!compatible) {
+				throw std::runtime_error(error_prefix + "entry '" + name +
+										 "' does not match the type or size "
+										 "of the receive object.");
+			}
+			group.entry_objects[e] = i;
+			found[i] = true;
+		}
+		for (size_t i = 0; i < found.size(); ++i) {
+			if (!found[i]) {
+				throw std::runtime_error(error_prefix + "key '" +
+										 group.keys[i] + "' not in the group.");
+			}
+		}
+		group.schema.assign(blob, schema_end);
+	}
+
+	// decode the values
+	const char* p = blob + schema_end;
+	for (uint32_t e = 0; e < num_entries; ++e) {
+		if (p + 4 > blob + len) {
+			throw std::runtime_error(error_prefix + "truncated values.");
+		}
+		const uint32_t size = readLittleEndian<uint32_t>(p);
+		p += 4;
+		if (p + size > blob + len) {
+			throw std::runtime_error(error_prefix + "truncated values.");
+		}
+		const int i = group.entry_objects[e];
+		if (i >= 0) {
+			const ReceiveObject& object = group.objects[i];
+			if (!object.codec->unpack(p, size, object.object)) {
+				throw std::runtime_error(error_prefix + "entry '" +
+										 group.keys[i] +
+										 "' does not match the size of the "
+										 "receive object.");
+			}
+		}
+		p += size;
+	}
+}
+
+RedisClient::GroupStatus RedisClient::sendAllFromGroup(
+	const std::string& group_name) {
+	return executeSendPlan(*compiledSendPlan(&group_name, 1));
+}
+
+RedisClient::GroupStatus RedisClient::sendAllFromGroup(
+	const std::vector<std::string>& group_names) {
+	return executeSendPlan(
+		*compiledSendPlan(group_names.data(), group_names.size()));
+}
+
+RedisClient::GroupStatus RedisClient::sendAllFromGroup(
+	const GroupHandle& group) {
+	return executeSendPlan(
+		*compiledSendPlan(sendGroup(group, "sendAllFromGroup")));
+}
+
+RedisClient::GroupStatus RedisClient::sendAllFromGroup(
+	const GroupListHandle& groups) {
+	return executeSendPlan(*compiledSendPlan(groups, "sendAllFromGroup"));
+}
+
+const std::shared_ptr<RedisClient::SendPlan>& RedisClient::compiledSendPlan(
+	const std::string* group_names, const size_t num_groups) {
+	// a single group has its own plan
+	if (num_groups == 1) {
+		return compiledSendPlan(sendGroup(group_names[0], "sendAllFromGroup"));
+	}
+
+	// reuse the plan compiled for that exact list of groups if any
+	for (const auto& plan : _send_plans) {
+		if (plan->group_names.size() == num_groups &&
+			std::equal(plan->group_names.begin(), plan->group_names.end(),
+					   group_names)) {
+			return plan;
+		}
+	}
+
+	std::vector<SendGroup*> groups;
+	for (size_t g = 0; g < num_groups; ++g) {
+		groups.push_back(&sendGroup(group_names[g], "sendAllFromGroup"));
+	}
+	_send_plans.push_back(std::make_shared<SendPlan>(
+		compileSendPlan(groups.data(), groups.size())));
+	_send_plans.back()->stats =
+		groupStats(_send_group_stats, group_names, num_groups);
+	return _send_plans.back();
+}
+
+const std::shared_ptr<RedisClient::SendPlan>& RedisClient::compiledSendPlan(
+	SendGroup& group) {
+	if (!group.plan) {
+		SendGroup* groups[] = {&group};
+		group.plan = std::make_shared<SendPlan>(compileSendPlan(groups, 1));
+		group.plan->stats = groupStats(_send_group_stats, &group.name, 1);
+	}
+	return group.plan;
+}
+
+const std::shared_ptr<RedisClient::SendPlan>& RedisClient::compiledSendPlan(
+	const GroupListHandle& groups, const char* action) {
+	if (groups.index >= _send_group_lists.size()) {
+		throw std::runtime_error("Send group list handle is invalid, cannot " +
+								 std::string(action));
+	}
+	SendGroupList& group_list = _send_group_lists[groups.index];
+	if (group_list.plan) return group_list.plan;
+
+	// a single group has its own plan
+	if (group_list.groups.size() == 1) {
+		return compiledSendPlan(sendGroup(group_list.groups[0], action));
+	}
+
+	// the plans are dropped when a group is deleted, so the handles are only
+	// checked when compiling
+	std::vector<SendGroup*> send_groups;
+	std::vector<std::string> group_names;
+	for (const GroupHandle& group : group_list.groups) {
+		send_groups.push_back(&sendGroup(group, action));
+		group_names.push_back(send_groups.back()->name);
+	}
+	group_list.plan = std::make_shared<SendPlan>(
+		compileSendPlan(send_groups.data(), send_groups.size()));
+	group_list.plan->stats = groupStats(_send_group_stats, group_names.data(),
+										group_names.size());
+	return group_list.plan;
+}
+
+RedisClient::SendPlan RedisClient::compileSendPlan(
+	SendGroup* const* groups, const size_t num_groups) const {
+	// freeze the groups into a flat plan
+	SendPlan plan;
+	plan.double_precision = _double_precision;
+	for (size_t g = 0; g < num_groups; ++g) {
+		const SendGroup& send_group = *groups[g];
+		plan.group_names.push_back(send_group.name);
+		const bool detect_changes = send_group.detect_changes;
+		if (detect_changes && send_group.full_refresh_interval > 0 &&
+			(plan.full_refresh_interval == 0 ||
+			 send_group.full_refresh_interval < plan.full_refresh_interval)) {
+			plan.full_refresh_interval = send_group.full_refresh_interval;
+		}
+
+		const auto& keys = send_group.keys;
+
+		if (!send_group.packed_key.empty()) {
+			PackedSendGroup group;
+			group.prefixed_key = _prefix + send_group.packed_key;
+			group.keys = keys;
+			group.objects = send_group.objects;
+			packGroupSchema(group);
+			plan.packed_groups.push_back(std::move(group));
+			continue;
+		}
+
+		// the objects of a hash group are fields of its HSET
+		int hash_command = -1;
+		if (!send_group.hash_key.empty()) {
+			HashSendCommand command;
+			command.prefixed_key = _prefix + send_group.hash_key;
+			command.argv.reserve(2 + 2 * keys.size());
+			command.argvlen.reserve(2 + 2 * keys.size());
+			hash_command = plan.hash_commands.size();
+			plan.hash_commands.push_back(std::move(command));
+		}
+
+		if (send_group.history) {
+			// the keys can be added after the history was enabled
+			for (const auto& key : keys) {
+				if (isHistoryField(key)) {
+					throw std::runtime_error(
+						"RedisClient: key '" + key + "' of send group [" +
+						send_group.name + "] is a reserved history field.");
+				}
+			}
+			HistoryCommand command;
+			command.prefixed_key = _prefix + send_group.history->stream_key;
+			command.max_length =
+				std::to_string(send_group.history->max_length);
+			command.history = send_group.history.get();
+			command.fields = keys;
+			for (size_t i = 0; i < keys.size(); ++i) {
+				command.objects.push_back(plan.objects.size() + i);
+			}
+			plan.history_commands.push_back(std::move(command));
+		}
+
+		for (size_t i = 0; i < keys.size(); ++i) {
+			plan.prefixed_keys.push_back(hash_command < 0 ? _prefix + keys[i]
+														  : keys[i]);
+			plan.objects.push_back(send_group.objects[i]);
+			plan.encodings.push_back(eigenEncodingForKey(keys[i]));
+			plan.detect_changes.push_back(detect_changes);
+			plan.hash_command_indexes.push_back(hash_command);
+		}
+	}
+	const size_t num_objects = plan.objects.size();
+	plan.values.resize(num_objects);
+	plan.last_sent.resize(num_objects);
+	plan.argv.reserve(1 + 2 * (num_objects + plan.packed_groups.size()));
+	plan.argvlen.reserve(1 + 2 * (num_objects + plan.packed_groups.size()));
+
+	// preallocate the encode buffers by encoding the current values once
+	for (size_t i = 0; i < num_objects; ++i) {
+		encodeSendPlanValue(plan, i);
+	}
+
+	return plan;
+}
+
+void RedisClient::encodeSendPlanValue(SendPlan& plan, const size_t i) {
+	std::string& value = plan.values[i];
+	value.clear();
+	const SendObject& object = plan.objects[i];
+	// strings are sent straight from the registered string, no copy
+	if (object.codec->string(object.object)) return;
+	object.codec->encode(object.object, plan.encodings[i],
+						 plan.double_precision, value);
+}
+
+void RedisClient::packGroupSchema(PackedSendGroup& group) {
+	using namespace RedisPackedGroup;
+	using RedisEigenBinary::writeLittleEndian;
+
+	const std::vector<std::string>& keys = group.keys;
+	group.shapes.resize(keys.size());
+	std::string& blob = group.blob;
+	blob.assign(HEADER_SIZE, '\0');
+	std::memcpy(&blob[0], MAGIC, sizeof(MAGIC));
+	blob[4] = (char)VERSION;
+	writeLittleEndian<uint32_t>(&blob[8], keys.size());
+
+	for (size_t i = 0; i < keys.size(); ++i) {
+		const SendObject& object = group.objects[i];
+		int rows = 0, cols = 0;
+		object.codec->shape(object.object, rows, cols);
+		group.shapes[i] = {rows, cols};
+		char entry[11];
+		writeLittleEndian<uint16_t>(entry, keys[i].size());
+		blob.append(entry, 2);
+		blob.append(keys[i]);
+		entry[0] = (char)object.codec->packed_type;
+		writeLittleEndian<uint32_t>(entry + 1, rows);
+		writeLittleEndian<uint32_t>(entry + 5, cols);
+		blob.append(entry, 9);
+	}
+	writeLittleEndian<uint32_t>(&blob[12], blob.size() - HEADER_SIZE);
+	group.schema_end = blob.size();
+}
+
+void RedisClient::packGroupValues(PackedSendGroup& group) {
+	// the header and schema are kept, only the values are rewritten, unless
+	// an object of dynamic size was resized
+	for (size_t i = 0; i < group.objects.size(); ++i) {
+		const SendObject& object = group.objects[i];
+		int rows = 0, cols = 0;
+		object.codec->shape(object.object, rows, cols);
+		if (group.shapes[i] != std::make_pair(rows, cols)) {
+			packGroupSchema(group);
+			break;
+		}
+	}
+	group.blob.resize(group.schema_end);
+	for (const auto& object : group.objects) {
+		object.codec->pack(object.object, group.blob);
+	}
+}
+
+bool RedisClient::sendPlanValueChanged(SendPlan& plan, const size_t i) {
+	const char* data = nullptr;
+	size_t size = 0;
+	plan.objects[i].codec->raw(plan.objects[i].object, data, size);
+
+	int rows = 0, cols = 0;
+	plan.objects[i].codec->shape(plan.objects[i].object, rows, cols);
+
+	SentValue& last_sent = plan.last_sent[i];
+	if (last_sent.sent && last_sent.rows == rows && last_sent.cols == cols &&
+		last_sent.bytes.size() == size &&
+		std::memcmp(last_sent.bytes.data(), data, size) == 0) {
+		return false;
+	}
+	last_sent.sent = true;
+	last_sent.rows = rows;
+	last_sent.cols = cols;
+	last_sent.bytes.assign(data, size);
+	return true;
+}
+
+void RedisClient::encodeSendPlan(SendPlan& plan) {
+	bool full_refresh = false;
+	if (plan.full_refresh_interval > 0 &&
+		++plan.sends_since_full_refresh >= plan.full_refresh_interval) {
+		plan.sends_since_full_refresh = 0;
+		full_refresh = true;
+	}
+
+	// only the encoded values change from one cycle to the next, the argument
+	// vectors keep their capacity
+	plan.argv.resize(1);
+	plan.argvlen.resize(1);
+	plan.argv[0] = "MSET";
+	plan.argvlen[0] = 4;
+	for (auto& command : plan.hash_commands) {
+		command.argv.assign({"HSET", command.prefixed_key.data()});
+		command.argvlen.assign({4, command.prefixed_key.size()});
+	}
+	for (size_t i = 0; i < plan.objects.size(); ++i) {
+		// unchanged objects are neither encoded nor sent
+		if (plan.detect_changes[i] && !sendPlanValueChanged(plan, i) &&
+			!full_refresh) {
+			continue;
+		}
+
+		const SendObject& object = plan.objects[i];
+		const std::string* value = object.codec->string(object.object);
+		if (!value) {
+			encodeSendPlanValue(plan, i);
+			value = &plan.values[i];
+		}
+
+		// empty values are not sent
+		if (value->empty()) continue;
+		std::vector<const char*>* argv = &plan.argv;
+		std::vector<size_t>* argvlen = &plan.argvlen;
+		if (plan.hash_command_indexes[i] >= 0) {
+			HashSendCommand& command =
+				plan.hash_commands[plan.hash_command_indexes[i]];
+			argv = &command.argv;
+			argvlen = &command.argvlen;
+		}
+		argv->push_back(plan.prefixed_keys[i].data());
+		argvlen->push_back(plan.prefixed_keys[i].size());
+		argv->push_back(value->data());
+		argvlen->push_back(value->size());
+	}
+
+	// one blob per packed group
+	for (auto& group : plan.packed_groups) {
+		packGroupValues(group);
+		plan.argv.push_back(group.prefixed_key.data());
+		plan.argvlen.push_back(group.prefixed_key.size());
+		plan.argv.push_back(group.blob.data());
+		plan.argvlen.push_back(group.blob.size());
+	}
+
+	// one sample of all the objects per historized group, also when the
+	// values did not change. The time is a wall clock time, like the server
+	// times of the stream entry ids used to select a time range.
+	if (plan.history_commands.empty()) return;
+	const long long time_ns =
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch())
+			.count();
+	char buffer[24];
+	for (auto& command : plan.history_commands) {
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer),
+									++command.history->sequence_number);
+		command.sequence_number.assign(buffer, result.ptr);
+		result = std::to_chars(buffer, buffer + sizeof(buffer), time_ns);
+		command.timestamp.assign(buffer, result.ptr);
+
+		command.argv.assign(
+			{"XADD", command.prefixed_key.data(), "MAXLEN", "~",
+			 command.max_length.data(), "*", HISTORY_SEQUENCE_FIELD.data(),
+			 command.sequence_number.data(), HISTORY_TIME_FIELD.data(),
+			 command.timestamp.data()});
+		command.argvlen.assign(
+			{4, command.prefixed_key.size(), 6, 1, command.max_length.size(),
+			 1, HISTORY_SEQUENCE_FIELD.size(), command.sequence_number.size(),
+			 HISTORY_TIME_FIELD.size(), command.timestamp.size()});
+		for (size_t j = 0; j < command.objects.size(); ++j) {
+			const size_t i = command.objects[j];
+			const SendObject& object = plan.objects[i];
+			const std::string* value = object.codec->string(object.object);
+			if (!value) value = &plan.values[i];
+			command.argv.push_back(command.fields[j].data());
+			command.argvlen.push_back(command.fields[j].size());
+			command.argv.push_back(value->data());
+			command.argvlen.push_back(value->size());
+		}
+	}
+}
+
+RedisClient::GroupStatus RedisClient::executeSendPlan(SendPlan& plan) {
+	StatsCounters& stats = *plan.stats;
+	if (!connectionReady()) {
+		stats.recordError();
+		return GROUP_DISCONNECTED;
+	}
+	const uint64_t start_ns = nowNs();
+	encodeSendPlan(plan);
+	const uint64_t encoded_ns = nowNs();
+	stats.recordEncode(encoded_ns - start_ns);
+
+	size_t num_keys = 0, num_bytes = 0;
+	const size_t num_commands =
+		appendSendPlanCommands(plan, num_keys, num_bytes);
+	if (num_commands == 0) return GROUP_OK;
+
+	if (!readPipelineReplies(num_commands)) {
+		stats.recordError();
+		if (_reconnector) {
+			connectionLost();
+			return GROUP_DISCONNECTED;
+		}
+		// the values were not sent, send them all next time
+		for (auto& last_sent : plan.last_sent) last_sent.sent = false;
+		throw std::runtime_error("RedisClient: MSET command failed.");
+	}
+	try {
+		checkSendPlanReplies(plan, 0, num_commands);
+	} catch (...) {
+		stats.recordError();
+		throw;
+	}
+	stats.recordCall(nowNs() - encoded_ns, num_keys, num_bytes,
+					 pipelineReplyBytes());
+	return GROUP_OK;
+}
+
+size_t RedisClient::appendSendPlanCommands(SendPlan& plan, size_t& num_keys,
+										   size_t& num_bytes) {
+	size_t num_commands = 0;
+	if (plan.argv.size() > 1) {
+		_transport->appendCommandArgv(plan.argv.size(), plan.argv.data(),
+									  plan.argvlen.data());
+		++num_commands;
+		num_keys += (plan.argv.size() - 1) / 2;
+		num_bytes += argumentBytes(plan.argvlen);
+	}
+	for (auto& command : plan.hash_commands) {
+		// no field to write
+		if (command.argv.size() == 2) continue;
+		_transport->appendCommandArgv(command.argv.size(),
+									  command.argv.data(),
+									  command.argvlen.data());
+		++num_commands;
+		num_keys += (command.argv.size() - 2) / 2;
+		num_bytes += argumentBytes(command.argvlen);
+	}
+	for (auto& command : plan.history_commands) {
+		_transport->appendCommandArgv(command.argv.size(),
+									  command.argv.data(),
+									  command.argvlen.data());
+		++num_commands;
+		num_bytes += argumentBytes(command.argvlen);
+	}
+	return num_commands;
+}
+
+size_t RedisClient::appendReceivePlanCommands(ReceivePlan& plan,
+											  size_t& num_keys,
+											  size_t& num_bytes) {
+	size_t num_commands = 0;
+	if (plan.argv.size() > 1) {
+		_transport->appendCommandArgv(plan.argv.size(), plan.argv.data(),
+									  plan.argvlen.data());
+		++num_commands;
+		num_keys += plan.argv.size() - 1;
+		num_bytes += argumentBytes(plan.argvlen);
+	}
+	for (auto& command : plan.hash_commands) {
+		_transport->appendCommandArgv(command.argv.size(),
+									  command.argv.data(),
+									  command.argvlen.data());
+		++num_commands;
+		num_keys += command.argv.size() - 2;
+		num_bytes += argumentBytes(command.argvlen);
+	}
+	return num_commands;
+}
+
+size_t RedisClient::replyBytes(const redisReply* reply) {
+	if (!reply) return 0;
+	size_t num_bytes = reply->str ? reply->len : 0;
+	for (size_t i = 0; i < reply->elements; ++i) {
+		num_bytes += replyBytes(reply->element[i]);
+	}
+	return num_bytes;
+}
+
+size_t RedisClient::pipelineReplyBytes() const {
+	size_t num_bytes = 0;
+	for (const auto& reply : _pipeline_replies) {
+		num_bytes += replyBytes(reply.get());
+	}
+	return num_bytes;
+}
+
+bool RedisClient::readPipelineReplies(const size_t num_replies) {
+	_pipeline_replies.clear();
+	for (size_t i = 0; i < num_replies; ++i) {
+		redisReply* r = nullptr;
+		if (_transport->getReply(&r) == REDIS_ERR) {
+			return false;
+		}
+		_pipeline_replies.emplace_back(r);
+	}
+	return true;
+}
+
+void RedisClient::checkSendPlanReplies(SendPlan& plan,
+									   const size_t first_reply,
+									   const size_t num_replies) {
+	for (size_t i = first_reply; i < first_reply + num_replies; ++i) {
+		const redisReply* reply = _pipeline_replies[i].get();
+		if (!reply || reply->type == REDIS_REPLY_ERROR) {
+			// the values were not sent, send them all next time
+			for (auto& last_sent : plan.last_sent) last_sent.sent = false;
+			throw std::runtime_error("RedisClient: MSET command failed.");
+		}
+	}
+}
+
+void RedisClient::decodeReceivePlanReplies(ReceivePlan& plan,
+										   const size_t first_reply) {
+	size_t i = first_reply;
+	if (plan.argv.size() > 1) {
+		decodeReceivePlanReply(plan, _pipeline_replies[i++].get());
+	}
+	for (const auto& command : plan.hash_commands) {
+		decodeHashReply(command, _pipeline_replies[i++].get());
+	}
+	publishReceiveSnapshots(plan);
+}
+
+void RedisClient::decodeHashReply(const HashReceiveCommand& command,
+								  const redisReply* reply) {
+	if (!reply || reply->type != REDIS_REPLY_ARRAY ||
+		reply->elements != command.decoders.size())
+		throw std::runtime_error("RedisClient: HMGET '" +
+								 command.prefixed_key + "' failed.");
+
+	for (size_t i = 0; i < command.decoders.size(); ++i) {
+		const redisReply* value = reply->element[i];
+		if (value->type != REDIS_REPLY_STRING)
+			throw std::runtime_error("RedisClient: field '" +
+									 command.fields[i] + "' of hash '" +
+									 command.prefixed_key + "' not found.");
+		const ReceiveDecoder& decoder = command.decoders[i];
+		decoder.decode(value->str, value->len, decoder.object);
+	}
+}
+
+void RedisClient::setSendGroupPacked(const std::string& group_name,
+									 const std::string& packed_key) {
+	SendGroup& group = sendGroup(group_name, "pack it");
+	if (!group.hash_key.empty() || group.history) {
+		throw std::runtime_error("Send group with name [" + group_name +
+								 "] is stored in a hash or historized, cannot "
+								 "pack it");
+	}
+
+	group.packed_key = packed_key;
+	clearSendPlans();
+}
+
+void RedisClient::setReceiveGroupPacked(const std::string& group_name,
+										const std::string& packed_key) {
+	ReceiveGroup& group = receiveGroup(group_name, "pack it");
+	if (group.cache || !group.hash_key.empty()) {
+		throw std::runtime_error("Receive group with name [" + group_name +
+								 "] is cached or read from a hash, cannot "
+								 "pack it");
+	}
+
+	group.packed_key = packed_key;
+	clearReceivePlans();
+}
+
+void RedisClient::setSendGroupHash(const std::string& group_name,
+								   const std::string& hash_key) {
+	SendGroup& group = sendGroup(group_name, "store it in a hash");
+	if (!group.packed_key.empty()) {
+		throw std::runtime_error("Send group with name [" + group_name +
+								 "] is packed, cannot store it in a hash");
+	}
+
+	group.hash_key = hash_key;
+	clearSendPlans();
+}
+
+void RedisClient::setReceiveGroupHash(const std::string& group_name,
+									  const std::string& hash_key) {
+	ReceiveGroup& group = receiveGroup(group_name, "read it from a hash");
+	if (!group.packed_key.empty() || group.cache) {
+		throw std::runtime_error("Receive group with name [" + group_name +
+								 "] is packed or cached, cannot read it from "
+								 "a hash");
+	}
+
+	group.hash_key = hash_key;
+	clearReceivePlans();
+}
+
+void RedisClient::setSendGroupHistory(const std::string& group_name,
+									  const std::string& stream_key,
+									  const size_t max_length) {
+	SendGroup& group = sendGroup(group_name, "keep its history");
+	if (!group.packed_key.empty()) {
+		throw std::runtime_error("Send group with name [" + group_name +
+								 "] is packed, cannot keep its history");
+	}
+
+	if (stream_key.empty()) {
+		group.history.reset();
+	} else {
+		requireServer("The history of a send group");
+		for (const auto& key : group.keys) {
+			if (isHistoryField(key)) {
+				throw std::runtime_error("Send group with name [" + group_name +
+										 "] has the key '" + key +
+										 "', reserved for the history");
+			}
+		}
+		// the sequence numbers continue if the group was already historized
+		if (!group.history) {
+			group.history.reset(new SendGroupHistory{stream_key, max_length, 0});
+		}
+		group.history->stream_key = stream_key;
+		group.history->max_length = max_length;
+	}
+	clearSendPlans();
+}
+
+void RedisClient::setSendGroupChangeDetection(
+	const std::string& group_name, const bool enabled,
+	const unsigned int full_refresh_interval) {
+	SendGroup& group = sendGroup(group_name, "set its change detection");
+	group.detect_changes = enabled;
+	group.full_refresh_interval = enabled ? full_refresh_interval : 0;
+	clearSendPlans();
+}
+
+RedisClient::GroupStatus RedisClient::sendAndReceiveAllFromGroup(
+	const std::string& send_group_name, const std::string& receive_group_name) {
+	SendPlan& send_plan = *compiledSendPlan(&send_group_name, 1);
+	return executeSendAndReceivePlans(
+		send_plan, *compiledReceivePlan(&receive_group_name, 1));
+}
+
+RedisClient::GroupStatus RedisClient::sendAndReceiveAllFromGroup(
+	const std::vector<std::string>& send_group_names,
+	const std::vector<std::string>& receive_group_names) {
+	SendPlan& send_plan =
+		*compiledSendPlan(send_group_names.data(), send_group_names.size());
+	return executeSendAndReceivePlans(
+		send_plan, *compiledReceivePlan(receive_group_names.data(),
+										receive_group_names.size()));
+}
+
+RedisClient::GroupStatus RedisClient::sendAndReceiveAllFromGroup(
+	const GroupListHandle& send_groups, const GroupListHandle& receive_groups) {
+	SendPlan& send_plan =
+		*compiledSendPlan(send_groups, "sendAndReceiveAllFromGroup");
+	return executeSendAndReceivePlans(
+		send_plan,
+		*compiledReceivePlan(receive_groups, "sendAndReceiveAllFromGroup"));
+}
+
+RedisClient::GroupStatus RedisClient::executeSendAndReceivePlans(
+	SendPlan& send_plan, ReceivePlan& receive_plan) {
+	StatsCounters& send_stats = *send_plan.stats;
+	StatsCounters& receive_stats = *receive_plan.stats;
+	if (!connectionReady()) {
+		send_stats.recordError();
+		receive_stats.recordError();
+		return GROUP_DISCONNECTED;
+	}
+
+	// pipeline the MSET and the MGET, then collect all the replies
+	const uint64_t start_ns = nowNs();
+	encodeSendPlan(send_plan);
+	const uint64_t encoded_ns = nowNs();
+	send_stats.recordEncode(encoded_ns - start_ns);
+
+	size_t num_send_keys = 0, num_send_bytes = 0;
+	size_t num_receive_keys = 0, num_receive_bytes = 0;
+	const size_t num_send_commands =
+		appendSendPlanCommands(send_plan, num_send_keys, num_send_bytes);
+	const size_t num_receive_commands = appendReceivePlanCommands(
+		receive_plan, num_receive_keys, num_receive_bytes);
+
+	if (!readPipelineReplies(num_send_commands + num_receive_commands)) {
+		send_stats.recordError();
+		receive_stats.recordError();
+		if (_reconnector) {
+			connectionLost();
+			return GROUP_DISCONNECTED;
+		}
+		// the values were not sent, send them all next time
+		for (auto& last_sent : send_plan.last_sent) last_sent.sent = false;
+		throw std::runtime_error(
+			"RedisClient: Pipeline MSET/MGET command failed.");
+	}
+	const uint64_t received_ns = nowNs();
+	try {
+		checkSendPlanReplies(send_plan, 0, num_send_commands);
+	} catch (...) {
+		send_stats.recordError();
+		throw;
+	}
+	try {
+		decodeReceivePlanReplies(receive_plan, num_send_commands);
+	} catch (...) {
+		receive_stats.recordError();
+		throw;
+	}
+	receive_stats.recordDecode(nowNs() - received_ns);
+
+	// both groups share the round trip, the replies of the send commands are
+	// only statuses
+	size_t num_send_reply_bytes = 0;
+	for (size_t i = 0; i < num_send_commands; ++i) {
+		num_send_reply_bytes += replyBytes(_pipeline_replies[i].get());
+	}
+	if (num_send_commands > 0) {
+		send_stats.recordCall(received_ns - encoded_ns, num_send_keys,
+							  num_send_bytes, num_send_reply_bytes);
+	}
+	if (num_receive_commands > 0) {
+		receive_stats.recordCall(received_ns - encoded_ns, num_receive_keys,
+								 num_receive_bytes,
+								 pipelineReplyBytes() - num_send_reply_bytes);
+	}
+	return GROUP_OK;
+}
+
+void RedisClient::connectAsync(const std::string& hostname, const int port) {
+	if (isInProcessUri(hostname) || isSharedMemoryUri(hostname)) {
+		throw std::runtime_error(
+			"RedisClient: Asynchronous connections need a redis server, not "
+			"available with " + hostname + ".");
+	}
+
+	// drop the previous connection, its pending requests fail silently
+	_async_context.reset(nullptr);
+	_async_requests.clear();
+	_async_error.clear();
+
+	redisAsyncContext* ac =
+		isUnixSocketUri(hostname)
+			? redisAsyncConnectUnix(
+				  hostname.substr(UNIX_SOCKET_URI_PREFIX.size()).c_str())
+			: redisAsyncConnect(hostname.c_str(), port);
+	if (!ac)
+		throw std::runtime_error(
+			"RedisClient: Could not allocate redis async context.");
+	if (ac->err) {
+		const std::string error(ac->errstr);
+		redisAsyncFree(ac);
+		throw std::runtime_error(
+			"RedisClient: Could not connect to redis server: " + error);
+	}
+
+	// the connection completes in the event loop
+	ac->data = this;
+	_async_adapter.reset(new RedisEpollAdapter());
+	_async_adapter->attach(ac);
+	redisAsyncSetConnectCallback(ac, &RedisClient::asyncConnectCallback);
+	redisAsyncSetDisconnectCallback(ac, &RedisClient::asyncDisconnectCallback);
+	_async_context.reset(ac);
+}
+
+void RedisClient::sendAllFromGroupAsync(const std::string& group_name) {
+	executeSendPlanAsync(compiledSendPlan(&group_name, 1));
+}
+
+void RedisClient::sendAllFromGroupAsync(
+	const std::vector<std::string>& group_names) {
+	executeSendPlanAsync(
+		compiledSendPlan(group_names.data(), group_names.size()));
+}
+
+void RedisClient::sendAllFromGroupAsync(const GroupListHandle& groups) {
+	executeSendPlanAsync(compiledSendPlan(groups, "sendAllFromGroupAsync"));
+}
+
+void RedisClient::startReceiveAllFromGroup(const std::string& group_name) {
+	executeReceivePlanAsync(compiledReceivePlan(&group_name, 1));
+}
+
+void RedisClient::startReceiveAllFromGroup(
+	const std::vector<std::string>& group_names) {
+	executeReceivePlanAsync(
+		compiledReceivePlan(group_names.data(), group_names.size()));
+}
+
+void RedisClient::startReceiveAllFromGroup(const GroupListHandle& groups) {
+	executeReceivePlanAsync(
+		compiledReceivePlan(groups, "startReceiveAllFromGroup"));
+}
+
+void RedisClient::executeSendPlanAsync(const std::shared_ptr<SendPlan>& plan) {
+	encodeSendPlan(*plan);
+	// hiredis copies the arguments, the plan buffers can be reused right away
+	if (plan->argv.size() > 1) {
+		issueAsyncCommand(plan->argv, plan->argvlen, {plan, nullptr, -1});
+	}
+	for (auto& command : plan->hash_commands) {
+		if (command.argv.size() == 2) continue;
+		issueAsyncCommand(command.argv, command.argvlen, {plan, nullptr, -1});
+	}
+	for (auto& command : plan->history_commands) {
+		issueAsyncCommand(command.argv, command.argvlen, {plan, nullptr, -1});
+	}
+}
+
+void RedisClient::executeReceivePlanAsync(
+	const std::shared_ptr<ReceivePlan>& plan) {
+	if (plan->argv.size() > 1) {
+		issueAsyncCommand(plan->argv, plan->argvlen, {nullptr, plan, -1});
+	}
+	for (size_t i = 0; i < plan->hash_commands.size(); ++i) {
+		issueAsyncCommand(plan->hash_commands[i].argv,
+						  plan->hash_commands[i].argvlen,
+						  {nullptr, plan, (int)i});
+	}
+}
+
+bool RedisClient::processAsyncEvents(const int timeout_ms) {
+	if (_async_adapter && !_async_requests.empty()) {
+		_async_adapter->process(timeout_ms);
+		// handle the other ready events without waiting
+		while (!_async_requests.empty() && _async_adapter->process(0)) {
+		}
+	}
+
+	if (!_async_error.empty()) {
+		std::string error;
+		error.swap(_async_error);
+		throw std::runtime_error(error);
+	}
+	return _async_requests.empty();
+}
+
+void RedisClient::waitForAsyncReplies() {
+	while (!processAsyncEvents(-1)) {
+	}
+}
+
+void RedisClient::issueAsyncCommand(std::vector<const char*>& argv,
+									const std::vector<size_t>& argvlen,
+									AsyncRequest request) {
+	if (!_async_context)
+		throw std::runtime_error(
+			"RedisClient: No asynchronous connection, call connectAsync "
+			"first.");
+
+	// replies come back in order, the callback pops the front request
+	_async_requests.push_back(std::move(request));
+	if (redisAsyncCommandArgv(_async_context.get(),
+							  &RedisClient::asyncReplyCallback, this,
+							  argv.size(), argv.data(),
+							  argvlen.data()) != REDIS_OK) {
+		_async_requests.pop_back();
+		throw std::runtime_error(
+			"RedisClient: Could not queue asynchronous command.");
+	}
+
+	// start writing without waiting for the next processAsyncEvents
+	_async_adapter->process(0);
+}
+
+void RedisClient::asyncReplyCallback(redisAsyncContext*, void* r,
+									 void* privdata) {
+	// must not throw, errors are reported by processAsyncEvents
+	RedisClient* client = static_cast<RedisClient*>(privdata);
+	if (client->_async_requests.empty()) return;
+	AsyncRequest request = std::move(client->_async_requests.front());
+	client->_async_requests.pop_front();
+
+	const redisReply* reply = static_cast<const redisReply*>(r);
+	// the values of a failed send may not have been written, send them all
+	// next time instead of skipping the unchanged ones
+	if (request.send_plan && (!reply || reply->type == REDIS_REPLY_ERROR)) {
+		for (auto& last_sent : request.send_plan->last_sent) last_sent.sent = false;
+	}
+	if (!reply) {
+		if (client->_async_error.empty())
+			client->_async_error =
+				"RedisClient: Asynchronous command failed, connection lost.";
+		return;
+	}
+
+	if (!request.receive_plan) {
+		if (reply->type == REDIS_REPLY_ERROR)
+			client->_async_error = "RedisClient: MSET command failed.";
+		return;
+	}
+	try {
+		if (request.hash_command >= 0) {
+			decodeHashReply(
+				request.receive_plan->hash_commands[request.hash_command],
+				reply);
+		} else {
+			client->decodeReceivePlanReply(*request.receive_plan, reply);
+		}
+		// the last reply of the plan completes the buffered groups
+		if (request.hash_command + 1 ==
+			(int)request.receive_plan->hash_commands.size()) {
+			publishReceiveSnapshots(*request.receive_plan);
+		}
+	} catch (const std::exception& e) {
+		client->_async_error = e.what();
+	}
+}
+
+void RedisClient::asyncConnectCallback(const redisAsyncContext* ac,
+									   const int status) {
+	if (status == REDIS_OK) return;
+	// hiredis frees the context after a failed connection
+	RedisClient* client = static_cast<RedisClient*>(ac->data);
+	client->_async_context.release();
+	client->_async_error =
+		"RedisClient: Could not connect to redis server: " +
+		std::string(ac->errstr ? ac->errstr : "unknown error");
+}
+
+void RedisClient::asyncDisconnectCallback(const redisAsyncContext* ac,
+										  const int status) {
+	if (status == REDIS_OK) return;
+	// hiredis frees the context after an unexpected disconnection
+	RedisClient* client = static_cast<RedisClient*>(ac->data);
+	client->_async_context.release();
+	client->_async_error =
+		"RedisClient: Asynchronous connection lost: " +
+		std::string(ac->errstr ? ac->errstr : "unknown error");
+}
+
+void RedisClient::subscribeToReceiveGroup(const std::string& group_name) {
+	const GroupHandle handle = receiveGroupHandle(group_name);
+	ReceiveGroup& group = receiveGroup(handle, "subscribe to it");
+	requireServer("Subscribing to a receive group");
+
+	enableKeyspaceNotifications(_transport->context());
+
+	// subscribe to the keyspace channel of each key of the group, or of its
+	// single key if packed
+	std::vector<std::string> keys = group.keys;
+	if (!group.packed_key.empty()) keys.assign(1, group.packed_key);
+	if (!group.hash_key.empty()) keys.assign(1, group.hash_key);
+	std::vector<std::string> channels;
+	for (const auto& key : keys) {
+		const std::string channel = KEYSPACE_CHANNEL_PREFIX + _prefix + key;
+		auto& groups = _keyspace_channel_groups[channel];
+		if (std::none_of(groups.begin(), groups.end(),
+						 [&handle](const GroupHandle& other) {
+							 return other.index == handle.index &&
+									other.generation == handle.generation;
+						 })) {
+			groups.push_back(handle);
+		}
+		channels.push_back(channel);
+	}
+	subscribeToChannels(channels);
+
+	// the values may have changed before the subscription
+	group.subscribed = true;
+	group.has_new_data = true;
+}
+
+bool RedisClient::receiveGroupHasNewData(const std::string& group_name) {
+	processSubscriptionMessages();
+	const ReceiveGroup& group =
+		receiveGroup(group_name, "check it for new data");
+	if (!group.subscribed) {
+		throw std::runtime_error("Receive group with name [" + group_name +
+								 "] is not subscribed to keyspace "
+								 "notifications");
+	}
+	return group.has_new_data;
+}
+
+bool RedisClient::receiveAllFromGroupIfUpdated(const std::string& group_name) {
+	if (!receiveGroupHasNewData(group_name)) return false;
+	// clear the flag first, a change during the MGET flags the group again
+	ReceiveGroup& group = receiveGroup(group_name, "receiveAllFromGroup");
+	group.has_new_data = false;
+	if (receiveAllFromGroup(group_name) != GROUP_OK) {
+		group.has_new_data = true;
+		return false;
+	}
+	return true;
+}
+
+void RedisClient::enableReceiveGroupCaching(const std::string& group_name) {
+	ReceiveGroup& group = receiveGroup(group_name, "enable caching");
+	requireServer("Client side caching");
+	if (!group.packed_key.empty() || !group.hash_key.empty()) {
+		throw std::runtime_error("Receive group with name [" + group_name +
+								 "] is packed or read from a hash, cannot "
+								 "enable caching");
+	}
+
+	if (!_client_tracking_enabled) {
+		// invalidation messages are redirected to the subscription connection
+		subscribeToChannels({TRACKING_INVALIDATION_CHANNEL});
+		auto reply = command("CLIENT TRACKING on REDIRECT %lld",
+							 _subscription_client_id);
+		if (!reply || reply->type == REDIS_REPLY_ERROR) {
+			throw std::runtime_error(
+				"RedisClient: CLIENT TRACKING failed (requires Redis 6 or "
+				"newer).");
+		}
+		_client_tracking_enabled = true;
+	}
+
+	// everything is fetched on the next receive
+	group.cache.reset(new CachedReceiveGroup());
+}
+
+RedisClient::GroupStatus RedisClient::receiveCachedGroup(
+	ReceiveGroup& group) {
+	processSubscriptionMessages();
+	CachedReceiveGroup& cache = *group.cache;
+	const auto& plan = compiledReceivePlan(group);
+	StatsCounters& stats = *plan->stats;
+	if (!connectionReady()) {
+		stats.recordError();
+		return GROUP_DISCONNECTED;
+	}
+
+	if (cache.stale.size() != plan->decoders.size()) {
+		// keys were added or removed, fetch everything
+		cache.stale.assign(plan->decoders.size(), true);
+		cache.key_indexes.clear();
+		for (size_t i = 0; i < plan->prefixed_keys.size(); ++i) {
+			cache.key_indexes[plan->prefixed_keys[i]] = i;
+		}
+	}
+
+	// MGET of the invalidated keys only
+	cache.argv.assign(1, "MGET");
+	cache.argvlen.assign(1, 4);
+	cache.fetched.clear();
+	for (size_t i = 0; i < cache.stale.size(); ++i) {
+		if (!cache.stale[i]) continue;
+		cache.argv.push_back(plan->argv[i + 1]);
+		cache.argvlen.push_back(plan->argvlen[i + 1]);
+		cache.fetched.push_back(i);
+	}
+	if (cache.fetched.empty()) return GROUP_OK;
+
+	const uint64_t start_ns = nowNs();
+	auto reply = commandArgv(cache.argv.size(), cache.argv.data(),
+							 cache.argvlen.data());
+	const uint64_t received_ns = nowNs();
+	if (!reply && _reconnector) {
+		stats.recordError();
+		connectionLost();
+		return GROUP_DISCONNECTED;
+	}
+	if (!reply || reply->type != REDIS_REPLY_ARRAY ||
+		reply->elements != cache.fetched.size()) {
+		stats.recordError();
+		throw std::runtime_error("RedisClient: MGET command failed.");
+	}
+
+	for (size_t j = 0; j < cache.fetched.size(); ++j) {
+		const redisReply* value = reply->element[j];
+		if (value->type != REDIS_REPLY_STRING) {
+			stats.recordError();
+			throw std::runtime_error(
+				"RedisClient: MGET command returned non-string values.");
+		}
+		const size_t i = cache.fetched[j];
+		const ReceiveDecoder& decoder = plan->decoders[i];
+		decoder.decode(value->str, value->len, decoder.object);
+		cache.stale[i] = false;
+	}
+	publishReceiveSnapshots(*plan);
+	stats.recordDecode(nowNs() - received_ns);
+	stats.recordCall(received_ns - start_ns, cache.fetched.size(),
+					 argumentBytes(cache.argvlen), replyBytes(reply.get()));
+	return GROUP_OK;
+}
+
+void RedisClient::setReceiveGroupBuffered(const std::string& group_name,
+										  const bool buffered) {
+	ReceiveGroup& group = receiveGroup(group_name, "buffer it");
+	if (buffered == (group.snapshots != nullptr)) return;
+	// the copies start from the current values of the objects
+	group.snapshots =
+		buffered ? createReceiveGroupSnapshots(group.objects) : nullptr;
+	clearReceivePlans();
+}
+
+bool RedisClient::readReceiveGroupSnapshot(const std::string& group_name) {
+	return readReceiveGroupSnapshot(
+		receiveGroup(group_name, "read its snapshot"));
+}
+
+bool RedisClient::readReceiveGroupSnapshot(const GroupHandle& group) {
+	return readReceiveGroupSnapshot(receiveGroup(group, "read its snapshot"));
+}
+
+bool RedisClient::readReceiveGroupSnapshot(ReceiveGroup& group) {
+	if (!group.snapshots) {
+		throw std::runtime_error("Receive group with name [" + group.name +
+								 "] is not buffered, cannot read its "
+								 "snapshot");
+	}
+	ReceiveGroupSnapshots& snapshots = *group.snapshots;
+	if (!(snapshots.middle.load(std::memory_order_relaxed) &
+		  ReceiveGroupSnapshots::NEW_SNAPSHOT)) {
+		return false;
+	}
+	snapshots.front =
+		snapshots.middle.exchange(snapshots.front, std::memory_order_acq_rel) &
+		~ReceiveGroupSnapshots::NEW_SNAPSHOT;
+	const auto& front = snapshots.copies[snapshots.front];
+	for (size_t i = 0; i < front.size(); ++i) {
+		front[i].codec->copy(front[i].object, group.objects[i].object);
+	}
+	return true;
+}
+
+std::shared_ptr<RedisClient::ReceiveGroupSnapshots>
+RedisClient::createReceiveGroupSnapshots(
+	const std::vector<ReceiveObject>& objects) {
+	auto snapshots = std::make_shared<ReceiveGroupSnapshots>();
+	for (const auto& object : objects) {
+		snapshots->staging.push_back(
+			{object.codec, object.codec->clone(object.object)});
+		for (auto& copy : snapshots->copies) {
+			copy.push_back({object.codec, object.codec->clone(object.object)});
+		}
+	}
+	return snapshots;
+}
+
+void RedisClient::publishReceiveSnapshots(const ReceivePlan& plan) {
+	for (const auto& snapshots : plan.snapshots) {
+		const auto& staging = snapshots->staging;
+		const auto& back = snapshots->copies[snapshots->back];
+		for (size_t i = 0; i < staging.size(); ++i) {
+			staging[i].codec->copy(staging[i].object, back[i].object);
+		}
+		snapshots->back =
+			snapshots->middle.exchange(
+				snapshots->back | ReceiveGroupSnapshots::NEW_SNAPSHOT,
+				std::memory_order_acq_rel) &
+			~ReceiveGroupSnapshots::NEW_SNAPSHOT;
+	}
+}
+
+RedisClient::ReceiveGroupSnapshots::~ReceiveGroupSnapshots() {
+	for (const auto& object : staging) object.codec->destroy(object.object);
+	for (const auto& copy : copies) {
+		for (const auto& object : copy) object.codec->destroy(object.object);
+	}
+}
+
+void RedisClient::StatsCounters::recordCall(const uint64_t latency_ns,
+											const size_t num_keys,
+											const size_t bytes_sent,
+											const size_t bytes_received) {
+	const uint64_t latency_us = latency_ns / 1000;
+	size_t bucket = 0;
+	while (bucket < Stats::NUM_LATENCY_BUCKETS - 1 &&
+		   (uint64_t(1) << bucket) <= latency_us) {
+		++bucket;
+	}
+	add(_latency_histogram[bucket], 1);
+	add(_num_calls, 1);
+	add(_num_keys, num_keys);
+	add(_bytes_sent, bytes_sent);
+	add(_bytes_received, bytes_received);
+	add(_round_trip_ns, latency_ns);
+	max(_max_latency_ns, latency_ns);
+}
+
+void RedisClient::StatsCounters::recordEncode(const uint64_t duration_ns) {
+	add(_encode_ns, duration_ns);
+}
+
+void RedisClient::StatsCounters::recordDecode(const uint64_t duration_ns) {
+	add(_decode_ns, duration_ns);
+}
+
+void RedisClient::StatsCounters::recordError() { add(_num_errors, 1); }
+
+void RedisClient::StatsCounters::reset() {
+	for (auto& count : _latency_histogram) {
+		count.store(0, std::memory_order_relaxed);
+	}
+	for (auto* counter :
+		 {&_num_calls, &_num_errors, &_num_keys, &_bytes_sent, &_bytes_received,
+		  &_round_trip_ns, &_encode_ns, &_decode_ns, &_max_latency_ns}) {
+		counter->store(0, std::memory_order_relaxed);
+	}
+}
+
+RedisClient::Stats RedisClient::StatsCounters::snapshot() const {
+	Stats stats;
+	for (size_t i = 0; i < Stats::NUM_LATENCY_BUCKETS; ++i) {
+		stats.latency_histogram[i] =
+			_latency_histogram[i].load(std::memory_order_relaxed);
+	}
+	stats.num_calls = _num_calls.load(std::memory_order_relaxed);
+	stats.num_errors = _num_errors.load(std::memory_order_relaxed);
+	stats.num_keys = _num_keys.load(std::memory_order_relaxed);
+	stats.bytes_sent = _bytes_sent.load(std::memory_order_relaxed);
+	stats.bytes_received = _bytes_received.load(std::memory_order_relaxed);
+	stats.round_trip_time =
+		_round_trip_ns.load(std::memory_order_relaxed) * 1e-9;
+	stats.encode_time = _encode_ns.load(std::memory_order_relaxed) * 1e-9;
+	stats.decode_time = _decode_ns.load(std::memory_order_relaxed) * 1e-9;
+	stats.max_latency = _max_latency_ns.load(std::memory_order_relaxed) * 1e-9;
+	return stats;
+}
+
+double RedisClient::Stats::latencyQuantile(const double fraction) const {
+	// the histogram and the number of calls of a snapshot taken during a call
+	// can differ by one, go by the histogram
+	uint64_t num_round_trips = 0;
+	for (const uint64_t count : latency_histogram) num_round_trips += count;
+	if (num_round_trips == 0) return 0;
+
+	const double target = fraction * num_round_trips;
+	uint64_t cumulated = 0;
+	for (size_t i = 0; i < NUM_LATENCY_BUCKETS - 1; ++i) {
+		cumulated += latency_histogram[i];
+		if (cumulated >= target) {
+			return std::min(double(uint64_t(1) << i) * 1e-6, max_latency);
+		}
+	}
+	return max_latency;
+}
+
+const std::shared_ptr<RedisClient::StatsCounters>& RedisClient::groupStats(
+	std::map<std::vector<std::string>, std::shared_ptr<StatsCounters>>&
+		group_stats,
+	const std::string* group_names, const size_t num_groups) {
+	std::lock_guard<std::mutex> lock(_stats_mutex);
+	auto& stats = group_stats[std::vector<std::string>(
+		group_names, group_names + num_groups)];
+	if (!stats) stats = std::make_shared<StatsCounters>();
+	return stats;
+}
+
+std::shared_ptr<const RedisClient::StatsCounters> RedisClient::sendGroupStats(
+	const std::string& group_name) {
+	return groupStats(_send_group_stats, &group_name, 1);
+}
+
+std::shared_ptr<const RedisClient::StatsCounters> RedisClient::sendGroupStats(
+	const std::vector<std::string>& group_names) {
+	return groupStats(_send_group_stats, group_names.data(),
+					  group_names.size());
+}
+
+std::shared_ptr<const RedisClient::StatsCounters>
+RedisClient::receiveGroupStats(const std::string& group_name) {
+	return groupStats(_receive_group_stats, &group_name, 1);
+}
+
+std::shared_ptr<const RedisClient::StatsCounters>
+RedisClient::receiveGroupStats(const std::vector<std::string>& group_names) {
+	return groupStats(_receive_group_stats, group_names.data(),
+					  group_names.size());
+}
+
+void RedisClient::resetStats() {
+	std::lock_guard<std::mutex> lock(_stats_mutex);
+	for (auto& stats : _command_stats) stats.reset();
+	for (auto& group_stats : _send_group_stats) group_stats.second->reset();
+	for (auto& group_stats : _receive_group_stats) group_stats.second->reset();
+}
+
+void RedisClient::subscribeToChannels(const std::vector<std::string>& channels) {
+	// subscriptions need their own connection
+	if (!_subscription_context) {
+		_subscription_context.reset(
+			connectToServer(_hostname, _port, _timeout));
+		if (!_subscription_context || _subscription_context->err) {
+			const std::string error =
+				_subscription_context ? _subscription_context->errstr
+									  : "could not allocate redis context";
+			_subscription_context.reset(nullptr);
+			throw std::runtime_error(
+				"RedisClient: Could not open subscription connection: " +
+				error);
+		}
+
+		// the id is needed to redirect the tracking invalidations, and can
+		// only be asked before subscribing
+		redisReply* r =
+			(redisReply*)redisCommand(_subscription_context.get(), "CLIENT ID");
+		std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
+		if (!reply || reply->type != REDIS_REPLY_INTEGER) {
+			_subscription_context.reset(nullptr);
+			throw std::runtime_error("RedisClient: CLIENT ID failed.");
+		}
+		_subscription_client_id = reply->integer;
+	}
+
+	// handle the messages received before the confirmations
+	if (!subscribe(_subscription_context.get(), channels,
+				   [this](const redisReply* reply) {
+					   handleSubscriptionMessage(reply);
+				   })) {
+		_subscription_context.reset(nullptr);
+		throw std::runtime_error("RedisClient: SUBSCRIBE failed.");
+	}
+}
+
+void RedisClient::processSubscriptionMessages() {
+	if (!_subscription_context) return;
+
+	// read whatever is available on the socket without blocking
+	struct pollfd pfd;
+	pfd.fd = _subscription_context->fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	while (poll(&pfd, 1, 0) > 0) {
+		if (redisBufferRead(_subscription_context.get()) == REDIS_ERR) {
+			_subscription_context.reset(nullptr);
+			// the messages may have been missed, fetch everything
+			for (auto& group : _receive_groups) {
+				if (group.subscribed) group.has_new_data = true;
+				if (group.cache) group.cache->stale.clear();
+			}
+			if (_reconnector) {
+				connectionLost();
+				return;
+			}
+			throw std::runtime_error(
+				"RedisClient: Subscription connection lost.");
+		}
+
+		redisReply* r = nullptr;
+		while (redisGetReplyFromReader(_subscription_context.get(),
+									   (void**)&r) == REDIS_OK &&
+			   r) {
+			std::unique_ptr<redisReply, redisReplyDeleter> reply(r);
+			handleSubscriptionMessage(reply.get());
+			r = nullptr;
+		}
+	}
+}
+
+void RedisClient::handleSubscriptionMessage(const redisReply* reply) {
+	// messages are ["message", <channel>, <payload>]
+	if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 3 ||
+		reply->element[0]->type != REDIS_REPLY_STRING ||
+		reply->element[1]->type != REDIS_REPLY_STRING ||
+		std::strcmp(reply->element[0]->str, "message") != 0) {
+		return;
+	}
+	const std::string channel(reply->element[1]->str, reply->element[1]->len);
+	const redisReply* payload = reply->element[2];
+
+	// tracking invalidation: the payload is the array of invalidated keys,
+	// or nil when the whole database was flushed
+	if (channel == TRACKING_INVALIDATION_CHANNEL) {
+		if (payload->type != REDIS_REPLY_ARRAY) {
+			for (auto& group : _receive_groups) {
+				if (group.cache) group.cache->stale.clear();
+			}
+			return;
+		}
+		for (size_t k = 0; k < payload->elements; ++k) {
+			if (payload->element[k]->type != REDIS_REPLY_STRING) continue;
+			const std::string key(payload->element[k]->str,
+								  payload->element[k]->len);
+			for (auto& group : _receive_groups) {
+				if (!group.cache) continue;
+				auto it = group.cache->key_indexes.find(key);
+				if (it != group.cache->key_indexes.end()) {
+					group.cache->stale[it->second] = true;
+				}
+			}
+		}
+		return;
+	}
+
+	// keyspace notification: the payload is the event name
+	auto it = _keyspace_channel_groups.find(channel);
+	if (it == _keyspace_channel_groups.end()) return;
+	for (const auto& handle : it->second) {
+		ReceiveGroup* group = findReceiveGroup(handle);
+		if (group && group->subscribed) group->has_new_data = true;
+	}
+}
+
+bool RedisClient::sendGroupExists(const std::string& group_name) const {
+	return _send_group_indexes.count(group_name) > 0;
+}
+
+bool RedisClient::receiveGroupExists(const std::string& group_name) const {
+	return _receive_group_indexes.count(group_name) > 0;
+}
+
+RedisClient::SendGroup& RedisClient::sendGroup(const std::string& group_name,
+											   const char* action) {
+	auto it = _send_group_indexes.find(group_name);
+	if (it == _send_group_indexes.end()) {
+		throw std::runtime_error("Send group with name [" + group_name +
+								 "] not found, cannot " + action);
+	}
+	return _send_groups[it->second];
+}
+
+RedisClient::SendGroup& RedisClient::sendGroup(const GroupHandle& group,
+											   const char* action) {
+	if (group.index >= _send_groups.size() ||
+		!_send_groups[group.index].in_use ||
+		_send_groups[group.index].generation != group.generation) {
+		throw std::runtime_error(
+			"Send group handle is invalid or its group was deleted, cannot " +
+			std::string(action));
+	}
+	return _send_groups[group.index];
+}
+
+RedisClient::ReceiveGroup& RedisClient::receiveGroup(
+	const std::string& group_name, const char* action) {
+	auto it = _receive_group_indexes.find(group_name);
+	if (it == _receive_group_indexes.end()) {
+		throw std::runtime_error("Receive group with name [" + group_name +
+								 "] not found, cannot " + action);
+	}
+	return _receive_groups[it->second];
+}
+
+RedisClient::ReceiveGroup& RedisClient::receiveGroup(const GroupHandle& group,
+													 const char* action) {
+	ReceiveGroup* receive_group = findReceiveGroup(group);
+	if (!receive_group) {
+		throw std::runtime_error(
+			"Receive group handle is invalid or its group was deleted, "
+			"cannot " +
+			std::string(action));
+	}
+	return *receive_group;
+}
+
+RedisClient::ReceiveGroup* RedisClient::findReceiveGroup(
+	const GroupHandle& group) {
+	if (group.index >= _receive_groups.size() ||
+		!_receive_groups[group.index].in_use ||
+		_receive_groups[group.index].generation != group.generation) {
+		return nullptr;
+	}
+	return &_receive_groups[group.index];
+}
+
+void RedisClient::clearSendPlans() {
+	_send_plans.clear();
+	for (auto& group : _send_groups) group.plan.reset();
+	for (auto& group_list : _send_group_lists) group_list.plan.reset();
+}
+
+void RedisClient::clearReceivePlans() {
+	_receive_plans.clear();
+	for (auto& group : _receive_groups) group.plan.reset();
+	for (auto& group_list : _receive_group_lists) group_list.plan.reset();
+}
+
+void RedisClient::appendDouble(std::string& str, const double value,
+							   const int precision) {
+	// locale independent, and without a temporary string
+	char buffer[32];
+	auto result =
+		precision > 0
+			? std::to_chars(buffer, buffer + sizeof(buffer), value,
+							std::chars_format::general, std::min(precision, 17))
+			: std::to_chars(buffer, buffer + sizeof(buffer), value);
+	str.append(buffer, result.ptr);
+}
+
+static inline const char* skipWhitespace(const char* ptr, const char* end) {
+	while (ptr < end && (*ptr == ' ' || *ptr == '\t' || *ptr == '\n' ||
+						 *ptr == '\r')) {
+		++ptr;
+	}
+	return ptr;
+}
+
+// parse a number with std::from_chars, tolerating the leading whitespace and
+// '+' sign that std::stod accepts. Returns nullptr on failure.
+template <typename T>
+static inline const char* parseNumber(const char* ptr, const char* end,
+									  T& value) {
+	ptr = skipWhitespace(ptr, end);
+	if (ptr < end && *ptr == '+') ++ptr;
+	auto result = std::from_chars(ptr, end, value);
+	if (result.ec != std::errc()) return nullptr;
+	return result.ptr;
+}
+
+double RedisClient::parseDouble(const char* str, const size_t len) {
+	double value;
+	if (!parseNumber(str, str + len, value)) {
+		throw std::runtime_error("RedisClient: Failed to decode double from: " +
+								 std::string(str, len) + ".");
+	}
+	return value;
+}
+
+int RedisClient::parseInt(const char* str, const size_t len) {
+	int value;
+	if (!parseNumber(str, str + len, value)) {
+		throw std::runtime_error("RedisClient: Failed to decode int from: " +
+								 std::string(str, len) + ".");
+	}
+	return value;
+}
+
+float RedisClient::parseFloat(const char* str, const size_t len) {
+	float value;
+	if (!parseNumber(str, str + len, value)) {
+		throw std::runtime_error("RedisClient: Failed to decode float from: " +
+								 std::string(str, len) + ".");
+	}
+	return value;
+}
+
+int64_t RedisClient::parseInt64(const char* str, const size_t len) {
+	int64_t value;
+	if (!parseNumber(str, str + len, value)) {
+		throw std::runtime_error("RedisClient: Failed to decode int64 from: " +
+								 std::string(str, len) + ".");
+	}
+	return value;
+}
+
+RedisClient::History RedisClient::getHistory(const std::string& stream_key,
+											 const std::string& key,
+											 const std::string& start,
+											 const std::string& end,
+											 const size_t count) {
+	const std::string key_with_prefix = _prefix + stream_key;
+	auto reply =
+		count > 0 ? command("XRANGE %s %s %s COUNT %llu",
+							key_with_prefix.c_str(), start.c_str(), end.c_str(),
+							(unsigned long long)count)
+				  : command("XRANGE %s %s %s", key_with_prefix.c_str(),
+							start.c_str(), end.c_str());
+	if (!reply || reply->type != REDIS_REPLY_ARRAY) {
+		throw std::runtime_error("RedisClient: XRANGE '" + key_with_prefix +
+								 "' failed.");
+	}
+
+	// entries are [id, [field, value, ...]]
+	History history;
+	const size_t num_samples = reply->elements;
+	history.timestamps.resize(num_samples);
+	history.sequence_numbers.resize(num_samples, -1);
+	history.ids.reserve(num_samples);
+	for (size_t s = 0; s < num_samples; ++s) {
+		const redisReply* entry = reply->element[s];
+		if (entry->type != REDIS_REPLY_ARRAY || entry->elements != 2 ||
+			entry->element[1]->type != REDIS_REPLY_ARRAY) {
+			throw std::runtime_error("RedisClient: XRANGE '" + key_with_prefix +
+									 "' returned an invalid entry.");
+		}
+		history.ids.emplace_back(entry->element[0]->str,
+								 entry->element[0]->len);
+
+		const redisReply* fields = entry->element[1];
+		const redisReply* value = nullptr;
+		long long time_ns = 0;
+		for (size_t f = 0; f + 1 < fields->elements; f += 2) {
+			const redisReply* field = fields->element[f];
+			const redisReply* field_value = fields->element[f + 1];
+			const char* value_end = field_value->str + field_value->len;
+			if (key.size() == field->len &&
+				std::memcmp(key.data(), field->str, field->len) == 0) {
+				value = field_value;
+			} else if (field->len == HISTORY_SEQUENCE_FIELD.size() &&
+					   std::memcmp(field->str, HISTORY_SEQUENCE_FIELD.data(),
+								   field->len) == 0) {
+				parseNumber(field_value->str, value_end,
+							history.sequence_numbers[s]);
+			} else if (field->len == HISTORY_TIME_FIELD.size() &&
+					   std::memcmp(field->str, HISTORY_TIME_FIELD.data(),
+								   field->len) == 0) {
+				parseNumber(field_value->str, value_end, time_ns);
+			}
+		}
+		if (!value) {
+			throw std::runtime_error("RedisClient: key '" + key +
+									 "' not found in history '" +
+									 key_with_prefix + "'.");
+		}
+		history.timestamps(s) = 1e-9 * time_ns;
+
+		// numbers are stored as 1x1 matrices
+		const std::string str(value->str, value->len);
+		Eigen::MatrixXd sample;
+		if (isBinaryEncodedEigenMatrix(str) ||
+			str.find('[') != std::string::npos) {
+			sample = decodeEigenMatrix(str);
+		} else {
+			sample = Eigen::MatrixXd::Constant(
+				1, 1, parseDouble(str.data(), str.size()));
+		}
+		if (s == 0) {
+			history.values.resize(sample.size(), num_samples);
+		} else if (sample.size() != history.values.rows()) {
+			throw std::runtime_error("RedisClient: size of key '" + key +
+									 "' changes in history '" +
+									 key_with_prefix + "'.");
+		}
+		history.values.col(s) =
+			Eigen::Map<const Eigen::VectorXd>(sample.data(), sample.size());
+	}
+	return history;
+}
+
+// read one binary coefficient of the given wire type as the target scalar
+template <typename T>
+static inline T readBinaryCoefficient(const char* ptr,
+									  const uint8_t scalar_type) {
+	switch (scalar_type) {
+		case RedisEigenBinary::FLOAT32:
+			return static_cast<T>(
+				RedisEigenBinary::readLittleEndian<float>(ptr));
+		case RedisEigenBinary::INT32:
+			return static_cast<T>(
+				RedisEigenBinary::readLittleEndian<int32_t>(ptr));
+		case RedisEigenBinary::INT64:
+			return static_cast<T>(
+				RedisEigenBinary::readLittleEndian<int64_t>(ptr));
+		default:
+			return static_cast<T>(
+				RedisEigenBinary::readLittleEndian<double>(ptr));
+	}
+}
+
+// parse one text coefficient as the target scalar. Integers written as
+// doubles ("1.0", "1e3") are read through a double.
+template <typename T>
+static inline const char* parseCoefficient(const char* ptr, const char* end,
+										   T& value) {
+	if constexpr (std::is_integral<T>::value) {
+		const char* next = parseNumber(ptr, end, value);
+		if (next &&
+			(next == end || (*next != '.' && *next != 'e' && *next != 'E'))) {
+			return next;
+		}
+		double number;
+		next = parseNumber(ptr, end, number);
+		if (next) value = static_cast<T>(number);
+		return next;
+	} else {
+		return parseNumber(ptr, end, value);
+	}
+}
+
+// single pass parse of the text format into column major storage. Returns
+// false if the value is malformed or does not match the expected shape.
+template <typename T>
+static bool decodeEigenTextInto(const char* ptr, const char* end, T* data,
+								const int rows, const int cols) {
+	ptr = skipWhitespace(ptr, end);
+	if (ptr == end || *ptr != '[') return false;
+	ptr = skipWhitespace(ptr + 1, end);
+	const bool nested = (ptr < end && *ptr == '[');
+
+	if (!nested) {
+		// "[1,2,3]" is a vector, either a column or a row one, "[]" an empty
+		// one
+		if (rows != 1 && cols != 1) return false;
+		const int size = rows * cols;
+		if (ptr < end && *ptr == ']') return size == 0;
+		int k = 0;
+		while (true) {
+			if (k >= size) return false;
+			ptr = parseCoefficient(ptr, end, data[k++]);
+			if (!ptr) return false;
+			ptr = skipWhitespace(ptr, end);
+			if (ptr == end) return false;
+			if (*ptr == ']') break;
+			if (*ptr != ',') return false;
+			++ptr;
+		}
+		return k == size;
+	}
+
+	// "[[1,2],[3,4]]" is a row major list of rows
+	int r = 0;
+	while (true) {
+		ptr = skipWhitespace(ptr, end);
+		if (ptr == end || *ptr != '[' || r >= rows) return false;
+		++ptr;
+		int c = 0;
+		while (true) {
+			if (c >= cols) return false;
+			ptr = parseCoefficient(ptr, end, data[r + rows * c++]);
+			if (!ptr) return false;
+			ptr = skipWhitespace(ptr, end);
+			if (ptr == end) return false;
+			if (*ptr == ']') break;
+			if (*ptr != ',') return false;
+			++ptr;
+		}
+		if (c != cols) return false;
+		++r;
+		ptr = skipWhitespace(ptr + 1, end);
+		if (ptr == end) return false;
+		if (*ptr == ']') break;
+		if (*ptr != ',') return false;
+		++ptr;
+	}
+	return r == rows;
+}
+
+template <typename T>
+static void decodeEigenInto(const char* str, const size_t len, T* data,
+							const int rows, const int cols) {
+	const char* end = str + len;
+	if (len >= RedisEigenBinary::HEADER_SIZE &&
+		std::memcmp(str, RedisEigenBinary::MAGIC, 4) == 0) {
+		const uint8_t scalar_type = str[5];
+		const size_t scalar_size = RedisEigenBinary::scalarSize(scalar_type);
+		const uint32_t value_rows =
+			RedisEigenBinary::readLittleEndian<uint32_t>(str + 8);
+		const uint32_t value_cols =
+			RedisEigenBinary::readLittleEndian<uint32_t>(str + 12);
+		// vectors are accepted in either orientation, as with the text format
+		const bool same_shape =
+			(value_rows == (uint32_t)rows && value_cols == (uint32_t)cols) ||
+			((rows == 1 || cols == 1) && (value_rows == 1 || value_cols == 1) &&
+			 (size_t)value_rows * value_cols == (size_t)rows * cols);
+		if ((uint8_t)str[4] != RedisEigenBinary::VERSION || scalar_size == 0 ||
+			!same_shape ||
+			len != RedisEigenBinary::HEADER_SIZE +
+					   (size_t)rows * cols * scalar_size) {
+			throw std::runtime_error(
+				"RedisClient: Failed to decode binary Eigen Matrix into a " +
+				std::to_string(rows) + "x" + std::to_string(cols) +
+				" object: header or size mismatch.");
+		}
+
+		const char* payload = str + RedisEigenBinary::HEADER_SIZE;
+		if (scalar_type == RedisEigenBinary::WireScalar<T>::id) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			for (int i = 0; i < rows * cols; ++i) {
+				data[i] =
+					RedisEigenBinary::readLittleEndian<T>(payload + i * sizeof(T));
+			}
+#else
+			std::memcpy(data, payload, rows * cols * sizeof(T));
+#endif
+		} else {
+			for (int i = 0; i < rows * cols; ++i) {
+				data[i] = readBinaryCoefficient<T>(payload, scalar_type);
+				payload += scalar_size;
+			}
+		}
+		return;
+	}
+
+	if (!decodeEigenTextInto(str, end, data, rows, cols)) {
+		throw std::runtime_error(
+			"RedisClient: Failed to decode Eigen Matrix into a " +
+			std::to_string(rows) + "x" + std::to_string(cols) +
+			" object from: " + std::string(str, len) + ".");
+	}
+}
+
+void RedisClient::decodeEigenMatrixInto(const char* str, const size_t len,
+										double* data, const int rows,
+										const int cols) {
+	decodeEigenInto(str, len, data, rows, cols);
+}
+
+void RedisClient::decodeEigenMatrixInto(const char* str, const size_t len,
+										float* data, const int rows,
+										const int cols) {
+	decodeEigenInto(str, len, data, rows, cols);
+}
+
+void RedisClient::decodeEigenMatrixInto(const char* str, const size_t len,
+										int32_t* data, const int rows,
+										const int cols) {
+	decodeEigenInto(str, len, data, rows, cols);
+}
+
+void RedisClient::decodeEigenMatrixInto(const char* str, const size_t len,
+										int64_t* data, const int rows,
+										const int cols) {
+	decodeEigenInto(str, len, data, rows, cols);
+}
+
+bool RedisClient::eigenMatrixShape(const char* str, const size_t len,
+								   int& rows, int& cols) {
+	if (len >= RedisEigenBinary::HEADER_SIZE &&
+		std::memcmp(str, RedisEigenBinary::MAGIC, 4) == 0) {
+		uint32_t value_rows, value_cols;
+		if (!RedisEigenBinary::readShape(str, len, value_rows, value_cols)) {
+			throw std::runtime_error(
+				"RedisClient: Failed to decode binary Eigen Matrix: header or "
+				"size mismatch.");
+		}
+		rows = value_rows;
+		cols = value_cols;
+		return true;
+	}
+
+	// count the rows of a nested list and the commas of its first row, or
+	// the commas of a flat list
+	const char* end = str + len;
+	const char* ptr = skipWhitespace(str, end);
+	if (ptr == end || *ptr != '[') return false;
+	const char* first = skipWhitespace(ptr + 1, end);
+	if (first < end && *first == ']') {
+		rows = 0;
+		cols = 1;
+		return true;
+	}
+	bool nested = false;
+	int depth = 0, num_rows = 0, num_commas = 0;
+	for (; ptr < end; ++ptr) {
+		if (*ptr == '[') {
+			if (++depth == 2) {
+				nested = true;
+				++num_rows;
+			}
+		} else if (*ptr == ']') {
+			if (--depth == 0) break;
+		} else if (*ptr == ',' && depth == (nested ? 2 : 1) && num_rows <= 1) {
+			++num_commas;
+		}
+	}
+	if (ptr == end) return false;
+	rows = nested ? num_rows : num_commas + 1;
+	cols = nested ? num_commas + 1 : 1;
+	return true;
+}
+
+static inline Eigen::MatrixXd decodeEigenMatrixWithDelimiters(
+	const std::string& str, char col_delimiter, char row_delimiter,
+	const std::string& delimiter_set, size_t idx_row_end = std::string::npos) {
+	// Count number of columns
+	size_t num_cols = 0;
 	size_t idx = 0;
 	size_t idx_col_end = str.find_first_of(row_delimiter);
 	while (idx < idx_col_end) {
@@ -636,7 +3344,60 @@ static inline Eigen::MatrixXd decodeEigenMatrixWithDelimiters(
 	return matrix;
 }
 
+bool RedisClient::isBinaryEncodedEigenMatrix(const std::string& str) {
+	return str.size() >= RedisEigenBinary::HEADER_SIZE &&
+		   std::memcmp(str.data(), RedisEigenBinary::MAGIC, 4) == 0;
+}
+
+Eigen::MatrixXd RedisClient::decodeEigenMatrixBinary(const std::string& str) {
+	if (!isBinaryEncodedEigenMatrix(str) ||
+		(uint8_t)str[4] != RedisEigenBinary::VERSION) {
+		throw std::runtime_error(
+			"RedisClient: Failed to decode binary Eigen Matrix: invalid "
+			"header.");
+	}
+
+	const uint8_t scalar_type = str[5];
+	uint32_t rows, cols;
+	if (!RedisEigenBinary::readShape(str.data(), str.size(), rows, cols)) {
+		throw std::runtime_error(
+			"RedisClient: Failed to decode binary Eigen Matrix: size "
+			"mismatch.");
+	}
+
+	// column major payload
+	const size_t scalar_size = RedisEigenBinary::scalarSize(scalar_type);
+	Eigen::MatrixXd matrix(rows, cols);
+	const char* payload = str.data() + RedisEigenBinary::HEADER_SIZE;
+	for (size_t i = 0; i < (size_t)rows * cols; ++i) {
+		switch (scalar_type) {
+			case RedisEigenBinary::FLOAT64:
+				matrix.data()[i] =
+					RedisEigenBinary::readLittleEndian<double>(payload);
+				break;
+			case RedisEigenBinary::FLOAT32:
+				matrix.data()[i] =
+					RedisEigenBinary::readLittleEndian<float>(payload);
+				break;
+			case RedisEigenBinary::INT32:
+				matrix.data()[i] =
+					RedisEigenBinary::readLittleEndian<int32_t>(payload);
+				break;
+			case RedisEigenBinary::INT64:
+				matrix.data()[i] =
+					RedisEigenBinary::readLittleEndian<int64_t>(payload);
+				break;
+		}
+		payload += scalar_size;
+	}
+	return matrix;
+}
+
 Eigen::MatrixXd RedisClient::decodeEigenMatrix(const std::string& str) {
+	if (isBinaryEncodedEigenMatrix(str)) {
+		return decodeEigenMatrixBinary(str);
+	}
+
 	// Find last nested row delimiter
 	size_t idx_row_end = str.find_last_of(']');
 	if (idx_row_end != std::string::npos) {
@@ -10,24 +10,37 @@
 #ifndef REDIS_CLIENT_H
 #define REDIS_CLIENT_H
 
+#include <hiredis/async.h>
 #include <hiredis/hiredis.h>
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
+#include "InProcessTransport.h"
+#include "RedisEpollAdapter.h"
+#include "RedisTransport.h"
+#include "SharedMemoryTransport.h"
+
 namespace SaiCommon {
 
 // \cond
-struct redisReplyDeleter {
-	void operator()(redisReply* r) { freeReplyObject(r); }
-};
-
-struct redisContextDeleter {
-	void operator()(redisContext* c) { redisFree(c); }
+struct redisAsyncContextDeleter {
+	void operator()(redisAsyncContext* c) { redisAsyncFree(c); }
 };
 // \endcond
 
@@ -39,17 +52,196 @@ struct redisContextDeleter {
  */
 class RedisClient {
 public:
+	/**
+	 * @brief Format used to encode Eigen objects in the redis database
+	 *
+	 * @details EIGEN_TEXT is the human readable JSON like format ("[1,2,3]" or
+	 * "[[1,2],[3,4]]"). EIGEN_BINARY is a 16 bytes header (magic, version,
+	 * scalar type, rows, cols) followed by the raw little endian coefficients
+	 * in column major order. Decoding always detects the format automatically,
+	 * so clients using different encodings can share the same keys.
+	 */
+	enum EigenEncoding {
+		EIGEN_TEXT,
+		EIGEN_BINARY,
+	};
+
+	/**
+	 * @brief Outcome of the group functions (sendAllFromGroup,
+	 * receiveAllFromGroup and sendAndReceiveAllFromGroup)
+	 *
+	 * @details Without automatic reconnection (see enableAutoReconnect), a
+	 * failure throws and GROUP_OK is the only value returned.
+	 */
+	enum GroupStatus {
+		// the values were sent or received
+		GROUP_OK,
+		// the connection is down and being reopened in the background:
+		// nothing was sent or received, the receive objects keep their last
+		// values
+		GROUP_DISCONNECTED,
+	};
+
+	/**
+	 * @brief Values of one key read from a send group history stream (see
+	 * setSendGroupHistory and getHistory)
+	 */
+	struct History {
+		// one column per sample, holding the value of the key (column major
+		// for matrices)
+		Eigen::MatrixXd values;
+		// wall clock time of the sender at each sample, in seconds since the
+		// Unix epoch, the clock of the millisecond times of the entry ids
+		Eigen::VectorXd timestamps;
+		// sequence number of each sample, consecutive unless samples were
+		// trimmed or lost
+		std::vector<long long> sequence_numbers;
+		// stream entry id of each sample, to continue reading after the last
+		// one with start = "(" + ids.back()
+		std::vector<std::string> ids;
+	};
+
+	/**
+	 * @brief Handle to a send or receive group, returned when the group is
+	 * created (or by sendGroupHandle and receiveGroupHandle). Operations
+	 * taking a handle access the group directly, without looking up its name.
+	 * A handle becomes invalid when its group is deleted.
+	 */
+	struct GroupHandle {
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0;
+	};
+
+	/**
+	 * @brief Handle to a fixed list of send or receive groups that are sent or
+	 * received together with a single redis call, returned by
+	 * sendGroupListHandle and receiveGroupListHandle. Operations taking it
+	 * use the plan compiled for that list directly, without comparing any
+	 * group name. It becomes invalid when one of its groups is deleted.
+	 */
+	struct GroupListHandle {
+		uint32_t index = UINT32_MAX;
+	};
+
+	/**
+	 * @brief Key-value commands with their own counters (see commandStats).
+	 * The get and set functions of all the types count as GET and SET.
+	 */
+	enum CommandType {
+		COMMAND_GET,
+		COMMAND_SET,
+		COMMAND_MGET,
+		COMMAND_MSET,
+		COMMAND_PIPEGET,
+		COMMAND_PIPESET,
+		NUM_COMMAND_TYPES,
+	};
+
+	/**
+	 * @brief Snapshot of the counters of a command type or of a group (see
+	 * StatsCounters)
+	 *
+	 * @details The round trip latency is the time between writing the
+	 * commands and reading the last reply, without the encoding and decoding
+	 * of the values which are timed separately. A group call that has
+	 * nothing to send (change detection) encodes without a round trip.
+	 */
+	struct Stats {
+		static constexpr size_t NUM_LATENCY_BUCKETS = 24;
+		// number of round trips per latency bucket: bucket k counts the
+		// latencies below 2^k microseconds (and above the previous bucket),
+		// the last bucket all the longer ones
+		std::array<uint64_t, NUM_LATENCY_BUCKETS> latency_histogram = {};
+		// round trips, and failed calls (including the calls returning
+		// GROUP_DISCONNECTED)
+		uint64_t num_calls = 0;
+		uint64_t num_errors = 0;
+		// keys (or hash fields) written or read, and bytes of their names and
+		// values
+		uint64_t num_keys = 0;
+		uint64_t bytes_sent = 0;
+		uint64_t bytes_received = 0;
+		// total times, in seconds
+		double round_trip_time = 0;
+		double encode_time = 0;
+		double decode_time = 0;
+		double max_latency = 0;
 
-	RedisClient() = default;
+		/**
+		 * @brief Latency below which a fraction of the round trips are (0.5
+		 * for the median, 0.99...), in seconds, rounded up to the upper bound
+		 * of its histogram bucket
+		 */
+		double latencyQuantile(const double fraction) const;
+	};
+
+	/**
+	 * @brief Live counters of a command type or of a group. They are updated
+	 * by the client without any lock, and snapshot() can be called at any
+	 * time from any thread, for example by a monitoring thread.
+	 */
+	class StatsCounters {
+	public:
+		Stats snapshot() const;
+
+	private:
+		friend class RedisClient;
+
+		void recordCall(const uint64_t latency_ns, const size_t num_keys,
+						const size_t bytes_sent, const size_t bytes_received);
+		void recordEncode(const uint64_t duration_ns);
+		void recordDecode(const uint64_t duration_ns);
+		void recordError();
+		void reset();
+
+		// read-modify-write operations, so that a reset or a record from
+		// another thread is never lost
+		static void add(std::atomic<uint64_t>& counter, const uint64_t value) {
+			counter.fetch_add(value, std::memory_order_relaxed);
+		}
+		static void max(std::atomic<uint64_t>& counter, const uint64_t value) {
+			uint64_t current = counter.load(std::memory_order_relaxed);
+			while (value > current &&
+				   !counter.compare_exchange_weak(current, value,
+												  std::memory_order_relaxed)) {
+			}
+		}
+
+		std::array<std::atomic<uint64_t>, Stats::NUM_LATENCY_BUCKETS>
+			_latency_histogram = {};
+		std::atomic<uint64_t> _num_calls{0};
+		std::atomic<uint64_t> _num_errors{0};
+		std::atomic<uint64_t> _num_keys{0};
+		std::atomic<uint64_t> _bytes_sent{0};
+		std::atomic<uint64_t> _bytes_received{0};
+		std::atomic<uint64_t> _round_trip_ns{0};
+		std::atomic<uint64_t> _encode_ns{0};
+		std::atomic<uint64_t> _decode_ns{0};
+		std::atomic<uint64_t> _max_latency_ns{0};
+	};
+
+	RedisClient();
 	RedisClient(const RedisClient&) = delete;
 	RedisClient& operator=(const RedisClient&) = delete;
 
 	RedisClient(const std::string& key_namespace_prefix);
 
+	~RedisClient();
+
 	/**
 	 * @brief Connect to Redis server.
 	 *
-	 * @param hostname  Redis server IP address (default 127.0.0.1).
+	 * @param hostname  Redis server IP address (default 127.0.0.1), or a unix
+	 * domain socket given as "unix://<socket path>" (for example
+	 * "unix:///var/run/redis.sock"), in which case the port is ignored.
+	 * "inprocess://<name>" exchanges the values with the clients of the same
+	 * process connected to the same name, without any server (see
+	 * InProcessTransport). "shm://<name>" exchanges them with the clients
+	 * of all the processes of the machine connected to the same name through
+	 * shared memory (see SharedMemoryTransport), the name defaulting to the
+	 * key namespace prefix. Its segment is created with the default sizes
+	 * and only accessible to the user, connect a SharedMemoryTransport for
+	 * others.
 	 * @param port      Redis server port number (default 6379).
 	 * @param timeout   Connection attempt timeout (default 1.5s).
 	 */
@@ -58,6 +250,63 @@ public:
 				 const int port = 6379,
 				 const struct timeval& timeout = {1, 500000});
 
+	/**
+	 * @brief Use a given transport as key-value backend. The get/set
+	 * functions and the groups work the same with any transport. The
+	 * subscriptions, client side caching, group history, automatic
+	 * reconnection and asynchronous connection need a redis server connected
+	 * with connect(hostname).
+	 *
+	 * @param transport  the backend, owned by the client
+	 */
+	void connect(std::unique_ptr<RedisTransport> transport);
+
+	/**
+	 * @brief Connect to a Redis server on the same machine through a unix
+	 * domain socket (the server must be started with the unixsocket option).
+	 * This has a lower latency than a TCP loopback connection, and all the
+	 * other functions work the same way.
+	 *
+	 * @param socket_path  Path of the Redis server socket.
+	 * @param timeout      Connection attempt timeout (default 1.5s).
+	 */
+	void connectUnix(const std::string& socket_path,
+					 const struct timeval& timeout = {1, 500000});
+
+	/**
+	 * @brief Keep the connection alive without ever blocking the group
+	 * functions on a broken connection. Must be called after connect().
+	 *
+	 * @details When the server restarts or the connection breaks, the group
+	 * functions return GROUP_DISCONNECTED immediately instead of throwing,
+	 * and a background thread reconnects to the server with an exponential
+	 * backoff. The thread also restores the client state on the new
+	 * connection before handing it over: the keys of the receive groups
+	 * missing on the server are set back to the last received values (packed
+	 * groups excepted), and the keyspace notification subscriptions and
+	 * client side caching are restored. The first group function called once
+	 * the connection is ready only takes it over, and the send groups are
+	 * then sent in full. The other functions (get, set...) keep throwing
+	 * while disconnected.
+	 *
+	 * A connection that stops answering without being closed is detected
+	 * when a command exceeds command_timeout, which bounds the longest stall
+	 * of a group function. The asynchronous connection is not reconnected.
+	 *
+	 * @param max_backoff_ms   longest wait between two reconnection attempts
+	 * (the first attempt is immediate, then the wait doubles from 10 ms)
+	 * @param command_timeout  timeout of the commands on the connection
+	 */
+	void enableAutoReconnect(
+		const int max_backoff_ms = 1000,
+		const struct timeval& command_timeout = {0, 100000});
+
+	/**
+	 * @brief Whether the connection is up, always true without automatic
+	 * reconnection (a failure throws instead)
+	 */
+	bool isConnected() const { return !_connection_lost; }
+
 	/**
 	 * @brief Perform Redis command: PING.
 	 *
@@ -129,7 +378,9 @@ public:
 	 * @param value  double value for key.
 	 */
 	inline void setDouble(const std::string& key, const double& value) {
-		set(key, std::to_string(value));
+		std::string str;
+		appendDouble(str, value, _double_precision);
+		set(key, str);
 	}
 
 	/**
@@ -164,7 +415,63 @@ public:
 	template <typename Derived>
 	inline void setEigen(const std::string& key,
 						 const Eigen::MatrixBase<Derived>& value) {
-		set(key, encodeEigenMatrix(value));
+		if (eigenEncodingForKey(key) == EIGEN_BINARY) {
+			set(key, encodeEigenMatrixBinary(value));
+		} else {
+			set(key, encodeEigenMatrix(value, _double_precision));
+		}
+	}
+
+	/**
+	 * @brief Set the number of significant digits of the doubles written as
+	 * text by this client (setDouble, setEigen and send groups). By default
+	 * (0), doubles are written with the shortest representation that reads
+	 * back to the exact same value. A lower precision gives smaller payloads.
+	 *
+	 * @param significant_digits  number of significant digits, 0 for the
+	 * shortest exact representation
+	 */
+	void setDoublePrecision(const int significant_digits) {
+		_double_precision = significant_digits;
+		clearSendPlans();
+	}
+
+	/**
+	 * @brief Set the default encoding used for all the Eigen objects written
+	 * by this client (setEigen and send groups). EIGEN_TEXT by default.
+	 *
+	 * @param encoding  the encoding to use
+	 */
+	void setEigenEncoding(const EigenEncoding encoding) {
+		_eigen_encoding = encoding;
+		clearSendPlans();
+	}
+
+	/**
+	 * @brief Set the encoding used for the Eigen object written to a given
+	 * key, overriding the client default for this key only
+	 *
+	 * @param key       the redis key (without the namespace prefix)
+	 * @param encoding  the encoding to use for this key
+	 */
+	void setEigenEncoding(const std::string& key, const EigenEncoding encoding) {
+		_eigen_key_encodings[key] = encoding;
+		clearSendPlans();
+	}
+
+	/**
+	 * @brief Get the encoding used when writing the Eigen object for a key
+	 *
+	 * @param key  the redis key (without the namespace prefix)
+	 * @return     the per key encoding if one was set, the client default
+	 * otherwise
+	 */
+	EigenEncoding eigenEncodingForKey(const std::string& key) const {
+		if (_eigen_key_encodings.empty()) {
+			return _eigen_encoding;
+		}
+		auto it = _eigen_key_encodings.find(key);
+		return it == _eigen_key_encodings.end() ? _eigen_encoding : it->second;
 	}
 
 	/**
@@ -182,6 +489,57 @@ public:
 	 */
 	bool exists(const std::string& key);
 
+	/**
+	 * Perform Redis GET commands in bulk: GET key1; GET key2...
+	 *
+	 * Pipeget gets multiple keys as a non-atomic operation. More efficient than
+	 * getting the keys separately. See:
+	 * https://redis.io/topics/mass-insert
+	 *
+	 * In C++11, this function can be called with brace initialization:
+	 * auto values = redis_client.pipeget({"key1", "key2"});
+	 *
+	 * @param keys  Vector of keys to get from Redis.
+	 * @return      Vector of retrieved values. Optimized with RVO.
+	 */
+	std::vector<std::string> pipeget(const std::vector<std::string>& keys);
+
+	/**
+	 * Perform Redis SET commands in bulk: SET key1 val1; SET key2 val2...
+	 *
+	 * Pipeset sets multiple keys as a non-atomic operation. More efficient than
+	 * setting the keys separately. See:
+	 * https://redis.io/topics/mass-insert
+	 *
+	 * In C++11, this function can be called with brace initialization:
+	 * redis_client.pipeset({{"key1", "val1"}, {"key2", "val2"}});
+	 *
+	 * @param keyvals  Vector of key-value pairs to set in Redis.
+	 */
+	void pipeset(
+		const std::vector<std::pair<std::string, std::string>>& keyvals);
+
+	/**
+	 * Perform Redis command: MGET key1 key2...
+	 *
+	 * MGET gets multiple keys as an atomic operation. See:
+	 * https://redis.io/commands/mget
+	 *
+	 * @param keys  Vector of keys to get from Redis.
+	 * @return      Vector of retrieved values. Optimized with RVO.
+	 */
+	std::vector<std::string> mget(const std::vector<std::string>& keys);
+
+	/**
+	 * Perform Redis command: MSET key1 val1 key2 val2...
+	 *
+	 * MSET sets multiple keys as an atomic operation. See:
+	 * https://redis.io/commands/mset
+	 *
+	 * @param keyvals  Vector of key-value pairs to set in Redis.
+	 */
+	void mset(const std::vector<std::pair<std::string, std::string>>& keyvals);
+
 	/**
 	 * @brief Create a New Send Group indexed by a group name (a group called
 	 * "default" is created by default)
@@ -191,8 +549,9 @@ public:
 	 * the sendAllFromGroup(group_name) function is called
 	 *
 	 * @param group_name name of the send group to create
+	 * @return handle to the group (to the existing one if any)
 	 */
-	void createNewSendGroup(const std::string& group_name);
+	GroupHandle createNewSendGroup(const std::string& group_name);
 
 	/**
 	 * @brief Create a New Receive Group indexed by indexed by a group name (a
@@ -203,8 +562,30 @@ public:
 	 * receiveAllFromGroup(group_name) function is called
 	 *
 	 * @param group_name name of the send group to create
+	 * @return handle to the group (to the existing one if any)
+	 */
+	GroupHandle createNewReceiveGroup(const std::string& group_name);
+
+	/**
+	 * @brief Get the handle of an existing send or receive group
+	 *
+	 * @param group_name name of the group
+	 * @return handle to the group
+	 */
+	GroupHandle sendGroupHandle(const std::string& group_name) const;
+	GroupHandle receiveGroupHandle(const std::string& group_name) const;
+
+	/**
+	 * @brief Get the handle of a list of send or receive groups, to send or
+	 * receive them together with a single redis call. Calling it again with
+	 * the same groups returns the same handle.
+	 *
+	 * @param groups  handles of the groups, in the order of the redis call
+	 * @return        handle to the list of groups
 	 */
-	void createNewReceiveGroup(const std::string& group_name);
+	GroupListHandle sendGroupListHandle(const std::vector<GroupHandle>& groups);
+	GroupListHandle receiveGroupListHandle(
+		const std::vector<GroupHandle>& groups);
 
 	/**
 	 * @brief Delete a send group by name
@@ -222,7 +603,12 @@ public:
 
 	/**
 	 * @brief Adds an object to be received in the given group. We can set up
-	 * strings, doubles, ints, bools, and Eigen objects to be received that way.
+	 * strings, doubles, floats, ints, int64_t, bools, Eigen matrices,
+	 * quaternions and transforms, std::array<double, N> and
+	 * std::vector<double> to be received that way. The values are decoded
+	 * straight into the storage of the object. Dynamic size Eigen objects and
+	 * vectors take the shape of the received value, and are only resized when
+	 * it changes.
 	 *
 	 * @param key The redis key of the object
 	 * @param object The object reference to populate with the value in the
@@ -245,10 +631,70 @@ public:
 						   Eigen::Matrix<_Scalar, _Rows, _Cols, _Options,
 										 _MaxRows, _MaxCols>& object,
 						   const std::string& group_name = "default");
+	void addToReceiveGroup(const std::string& key, float& object,
+						   const std::string& group_name = "default");
+	void addToReceiveGroup(const std::string& key, int64_t& object,
+						   const std::string& group_name = "default");
+	void addToReceiveGroup(const std::string& key, std::vector<double>& object,
+						   const std::string& group_name = "default");
+	template <typename _Scalar, int _Options>
+	void addToReceiveGroup(const std::string& key,
+						   Eigen::Quaternion<_Scalar, _Options>& object,
+						   const std::string& group_name = "default");
+	template <typename _Scalar, int _Dim, int _Mode, int _Options>
+	void addToReceiveGroup(
+		const std::string& key,
+		Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+		const std::string& group_name = "default");
+	template <size_t N>
+	void addToReceiveGroup(const std::string& key,
+						   std::array<double, N>& object,
+						   const std::string& group_name = "default");
+
+	/**
+	 * @brief Same as addToReceiveGroup with a group name, for the group of a
+	 * handle
+	 */
+	void addToReceiveGroup(const std::string& key, double& object,
+						   const GroupHandle& group);
+	void addToReceiveGroup(const std::string& key, std::string& object,
+						   const GroupHandle& group);
+	void addToReceiveGroup(const std::string& key, int& object,
+						   const GroupHandle& group);
+	void addToReceiveGroup(const std::string& key, bool& object,
+						   const GroupHandle& group);
+	template <typename _Scalar, int _Rows, int _Cols, int _Options,
+			  int _MaxRows, int _MaxCols>
+	void addToReceiveGroup(const std::string& key,
+						   Eigen::Matrix<_Scalar, _Rows, _Cols, _Options,
+										 _MaxRows, _MaxCols>& object,
+						   const GroupHandle& group);
+	void addToReceiveGroup(const std::string& key, float& object,
+						   const GroupHandle& group);
+	void addToReceiveGroup(const std::string& key, int64_t& object,
+						   const GroupHandle& group);
+	void addToReceiveGroup(const std::string& key, std::vector<double>& object,
+						   const GroupHandle& group);
+	template <typename _Scalar, int _Options>
+	void addToReceiveGroup(const std::string& key,
+						   Eigen::Quaternion<_Scalar, _Options>& object,
+						   const GroupHandle& group);
+	template <typename _Scalar, int _Dim, int _Mode, int _Options>
+	void addToReceiveGroup(
+		const std::string& key,
+		Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+		const GroupHandle& group);
+	template <size_t N>
+	void addToReceiveGroup(const std::string& key,
+						   std::array<double, N>& object,
+						   const GroupHandle& group);
 
 	/**
 	 * @brief Adds an object to be sent in the given group. We can set up
-	 * strings, doubles, ints, bools and Eigen objects to be sent that way.
+	 * strings, doubles, floats, ints, int64_t, bools, Eigen matrices,
+	 * quaternions (as their coefficients x, y, z, w) and transforms (as their
+	 * matrix), std::array<double, N> and std::vector<double> to be sent that
+	 * way. The values are encoded straight from the storage of the object.
 	 *
 	 * @param key The redis key of the object
 	 * @param object The object reference to send to the database for the given
@@ -271,179 +717,1505 @@ public:
 						const Eigen::Matrix<_Scalar, _Rows, _Cols, _Options,
 											_MaxRows, _MaxCols>& object,
 						const std::string& group_name = "default");
+	void addToSendGroup(const std::string& key, const float& object,
+						const std::string& group_name = "default");
+	void addToSendGroup(const std::string& key, const int64_t& object,
+						const std::string& group_name = "default");
+	void addToSendGroup(const std::string& key,
+						const std::vector<double>& object,
+						const std::string& group_name = "default");
+	template <typename _Scalar, int _Options>
+	void addToSendGroup(const std::string& key,
+						const Eigen::Quaternion<_Scalar, _Options>& object,
+						const std::string& group_name = "default");
+	template <typename _Scalar, int _Dim, int _Mode, int _Options>
+	void addToSendGroup(
+		const std::string& key,
+		const Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+		const std::string& group_name = "default");
+	template <size_t N>
+	void addToSendGroup(const std::string& key,
+						const std::array<double, N>& object,
+						const std::string& group_name = "default");
+
+	/**
+	 * @brief Same as addToSendGroup with a group name, for the group of a
+	 * handle
+	 */
+	void addToSendGroup(const std::string& key, const double& object,
+						const GroupHandle& group);
+	void addToSendGroup(const std::string& key, const std::string& object,
+						const GroupHandle& group);
+	void addToSendGroup(const std::string& key, const int& object,
+						const GroupHandle& group);
+	void addToSendGroup(const std::string& key, const bool& object,
+						const GroupHandle& group);
+	template <typename _Scalar, int _Rows, int _Cols, int _Options,
+			  int _MaxRows, int _MaxCols>
+	void addToSendGroup(const std::string& key,
+						const Eigen::Matrix<_Scalar, _Rows, _Cols, _Options,
+											_MaxRows, _MaxCols>& object,
+						const GroupHandle& group);
+	void addToSendGroup(const std::string& key, const float& object,
+						const GroupHandle& group);
+	void addToSendGroup(const std::string& key, const int64_t& object,
+						const GroupHandle& group);
+	void addToSendGroup(const std::string& key,
+						const std::vector<double>& object,
+						const GroupHandle& group);
+	template <typename _Scalar, int _Options>
+	void addToSendGroup(const std::string& key,
+						const Eigen::Quaternion<_Scalar, _Options>& object,
+						const GroupHandle& group);
+	template <typename _Scalar, int _Dim, int _Mode, int _Options>
+	void addToSendGroup(
+		const std::string& key,
+		const Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+		const GroupHandle& group);
+	template <size_t N>
+	void addToSendGroup(const std::string& key,
+						const std::array<double, N>& object,
+						const GroupHandle& group);
 
 	/**
 	 * @brief Pull from redis all the values for the objects of that group that
 	 * were set up via the addToReceiveGroup(goup_name) function
 	 *
+	 * @details The first call for a given group (or list of groups) compiles
+	 * it into a receive plan holding the MGET arguments and one typed decoder
+	 * per object. Subsequent calls reuse the cached command and decode the
+	 * reply straight into the registered objects. The plans are recompiled
+	 * automatically when a receive group is modified.
+	 *
 	 * @param group_name name of the group that contains the objects to update
+	 * @return GROUP_OK, or GROUP_DISCONNECTED (see enableAutoReconnect)
 	 */
-	void receiveAllFromGroup(const std::string& group_name = "default");
+	GroupStatus receiveAllFromGroup(const std::string& group_name = "default");
 
 	/**
 	 * @brief Performs the receiveAllFromGroup function for multiple groups with
-	 * a single redis call
+	 * a single redis call. The list of names is compared with the compiled
+	 * lists at each call, a control loop should rather use a GroupListHandle.
 	 *
 	 * @param group_names vector of group names to receive
 	 */
-	void receiveAllFromGroup(const std::vector<std::string>& group_names);
+	GroupStatus receiveAllFromGroup(
+		const std::vector<std::string>& group_names);
+
+	/**
+	 * @brief Same as receiveAllFromGroup with a group name, for the group of a
+	 * handle, without any lookup of the group name
+	 *
+	 * @param group handle of the group that contains the objects to update
+	 */
+	GroupStatus receiveAllFromGroup(const GroupHandle& group);
+
+	/**
+	 * @brief Same as receiveAllFromGroup with a list of group names, for the
+	 * groups of a list handle (see receiveGroupListHandle)
+	 *
+	 * @param groups handle of the list of groups to receive
+	 */
+	GroupStatus receiveAllFromGroup(const GroupListHandle& groups);
 
 	/**
 	 * @brief Push to redis all the values of the objects of that group that were set
 	 * up via the addToSendGroup(group_name) function
 	 *
+	 * @details The first call for a given group (or list of groups) compiles
+	 * it into a send plan holding the prefixed keys, the MSET argument
+	 * vectors and the encode buffers. Subsequent calls only re-encode the
+	 * values into those buffers and issue a single MSET. The plans are
+	 * recompiled automatically when a send group or an Eigen encoding is
+	 * modified.
+	 *
 	 * @param group_name name of the group that contains the objects to send
+	 * @return GROUP_OK, or GROUP_DISCONNECTED (see enableAutoReconnect)
 	 */
-	void sendAllFromGroup(const std::string& group_name = "default");
+	GroupStatus sendAllFromGroup(const std::string& group_name = "default");
 
 	/**
 	 * @brief Performs the sendAllFromGroup function for multiple groups with a
-	 * single redis call
+	 * single redis call. The list of names is compared with the compiled
+	 * lists at each call, a control loop should rather use a GroupListHandle.
 	 * 
 	 * @param group_names vector of group names to send
 	 */
-	void sendAllFromGroup(const std::vector<std::string>& group_names);
+	GroupStatus sendAllFromGroup(const std::vector<std::string>& group_names);
 
-private:
 	/**
-	 * private variables for automating pipeget and pipeset
+	 * @brief Same as sendAllFromGroup with a group name, for the group of a
+	 * handle, without any lookup of the group name
+	 *
+	 * @param group handle of the group that contains the objects to send
 	 */
-	enum RedisSupportedTypes {
-		INT_NUMBER,
-		DOUBLE_NUMBER,
-		BOOL,
-		STRING,
-		EIGEN_OBJECT,
-	};
+	GroupStatus sendAllFromGroup(const GroupHandle& group);
 
 	/**
-	 * Issue a command to Redis.
-	 *
-	 * This function is a C++ wrapper around hiredis::redisCommand() that
-	 * provides a self-freeing redisReply pointer. The command is formatted in
-	 * printf() style.
+	 * @brief Same as sendAllFromGroup with a list of group names, for the
+	 * groups of a list handle (see sendGroupListHandle)
 	 *
-	 * @param format  Format string.
-	 * @param ...     Format values.
-	 * @return        redisReply pointer.
+	 * @param groups handle of the list of groups to send
 	 */
-	std::unique_ptr<redisReply, redisReplyDeleter> command(const char* format,
-														   ...);
+	GroupStatus sendAllFromGroup(const GroupListHandle& groups);
 
 	/**
-	 * Encode Eigen::MatrixXd as JSON.
-	 *
-	 * encodeEigenMatrixJSON():
-	 *   [1,2,3,4]     => "[1,2,3,4]"
-	 *   [[1,2],[3,4]] => "[[1,2],[3,4]]"
+	 * @brief Only send the objects of a send group whose value changed since
+	 * they were last sent. A copy of the shape and raw bytes of each object
+	 * is kept and compared at each send, and the unchanged objects are
+	 * neither encoded nor included in the MSET. Each object is sent the first
+	 * time, even if it is empty. A full send can be forced periodically, so
+	 * that keys modified or deleted by other clients are eventually restored.
 	 *
-	 * @param matrix  Eigen::MatrixXd to encode.
-	 * @return        Encoded string.
+	 * @param group_name             name of the send group
+	 * @param enabled                enable or disable the change detection
+	 * @param full_refresh_interval  send all the objects every this many
+	 * sends of the group (0 for never). When groups are sent together, the
+	 * smallest interval applies.
 	 */
-	template <typename Derived>
-	static std::string encodeEigenMatrix(
-		const Eigen::MatrixBase<Derived>& matrix);
+	void setSendGroupChangeDetection(
+		const std::string& group_name, const bool enabled,
+		const unsigned int full_refresh_interval = 0);
 
 	/**
-	 * Decode Eigen::MatrixXd from JSON.
-	 *
-	 * decodeEigenMatrixJSON():
-	 *   "[1,2,3,4]"     => [1,2,3,4]
-	 *   "[[1,2],[3,4]]" => [[1,2],[3,4]]
+	 * @brief Store a whole send group in a single key, as one binary blob
+	 * holding a schema (keys, types and shapes of the objects) followed by
+	 * the values. Sending the group then sets one key instead of one per
+	 * object, and a receiver with the same group packed reads it with one
+	 * GET. The change detection does not apply to packed groups.
 	 *
-	 * @param str  String to decode.
-	 * @return     Decoded Eigen::Matrix. Optimized with RVO.
+	 * @param group_name  name of the send group
+	 * @param packed_key  key of the blob (prefixed like the other keys), or an
+	 * empty string to go back to one key per object
 	 */
-	static Eigen::MatrixXd decodeEigenMatrix(const std::string& str);
+	void setSendGroupPacked(const std::string& group_name,
+							const std::string& packed_key);
 
 	/**
-	 * Perform Redis GET commands in bulk: GET key1; GET key2...
-	 *
-	 * Pipeget gets multiple keys as a non-atomic operation. More efficient than
-	 * getting the keys separately. See:
-	 * https://redis.io/topics/mass-insert
-	 *
-	 * In C++11, this function can be called with brace initialization:
-	 * auto values = redis_client.pipeget({"key1", "key2"});
+	 * @brief Read a whole receive group from a single key written by a packed
+	 * send group (see setSendGroupPacked). The objects are matched to the blob
+	 * entries by key, and must have the type and shape of the sent ones. The
+	 * blob may contain more entries than the receive group.
 	 *
-	 * @param keys  Vector of keys to get from Redis.
-	 * @return      Vector of retrieved values. Optimized with RVO.
+	 * @param group_name  name of the receive group
+	 * @param packed_key  key of the blob (prefixed like the other keys), or an
+	 * empty string to go back to one key per object
 	 */
-	std::vector<std::string> pipeget(const std::vector<std::string>& keys);
+	void setReceiveGroupPacked(const std::string& group_name,
+							   const std::string& packed_key);
 
 	/**
-	 * Perform Redis SET commands in bulk: SET key1 val1; SET key2 val2...
-	 *
-	 * Pipeset sets multiple keys as a non-atomic operation. More efficient than
-	 * setting the keys separately. See:
-	 * https://redis.io/topics/mass-insert
-	 *
-	 * In C++11, this function can be called with brace initialization:
-	 * redis_client.pipeset({{"key1", "val1"}, {"key2", "val2"}});
+	 * @brief Store a send group in a single Redis hash, each object being a
+	 * field named by its key. Sending the group writes the fields with one
+	 * HSET, and with the change detection enabled (see
+	 * setSendGroupChangeDetection) only the modified fields are written. The
+	 * fields are encoded like the values of individual keys.
 	 *
-	 * @param keyvals  Vector of key-value pairs to set in Redis.
+	 * @param group_name  name of the send group
+	 * @param hash_key    key of the hash (prefixed like the other keys), or an
+	 * empty string to go back to one key per object
 	 */
-	void pipeset(
-		const std::vector<std::pair<std::string, std::string>>& keyvals);
+	void setSendGroupHash(const std::string& group_name,
+						  const std::string& hash_key);
 
 	/**
-	 * Perform Redis command: MGET key1 key2...
-	 *
-	 * MGET gets multiple keys as an atomic operation. See:
-	 * https://redis.io/commands/mget
+	 * @brief Read a receive group from the fields of a single Redis hash (see
+	 * setSendGroupHash) with one HMGET. The group can contain only some of
+	 * the fields of the hash.
 	 *
-	 * @param keys  Vector of keys to get from Redis.
-	 * @return      Vector of retrieved values. Optimized with RVO.
+	 * @param group_name  name of the receive group
+	 * @param hash_key    key of the hash (prefixed like the other keys), or an
+	 * empty string to go back to one key per object
 	 */
-	std::vector<std::string> mget(const std::vector<std::string>& keys);
+	void setReceiveGroupHash(const std::string& group_name,
+							 const std::string& hash_key);
 
 	/**
-	 * Perform Redis command: MSET key1 val1 key2 val2...
+	 * @brief Keep the history of a send group in a capped Redis stream. Each
+	 * send of the group then also appends (XADD) the values of all its
+	 * objects to the stream, in the same pipeline as the live update, with a
+	 * sequence number and the wall clock time of the sender (fields "__seq"
+	 * and "__time", in nanoseconds since the Unix epoch, which the keys of
+	 * the group cannot use). The stream entry ids hold the time of the
+	 * server on the same clock, in milliseconds, so that the samples can be
+	 * selected by time with getHistory. Packed groups cannot be historized.
 	 *
-	 * MSET sets multiple keys as an atomic operation. See:
-	 * https://redis.io/commands/mset
+	 * @param group_name  name of the send group
+	 * @param stream_key  key of the stream (prefixed like the other keys), or
+	 * an empty string to stop the history
+	 * @param max_length  approximate maximum number of samples kept
+	 */
+	void setSendGroupHistory(const std::string& group_name,
+							 const std::string& stream_key,
+							 const size_t max_length = 10000);
+
+	/**
+	 * @brief Read the values of one key from a history stream (XRANGE)
 	 *
-	 * @param keyvals  Vector of key-value pairs to set in Redis.
+	 * @param stream_key  key of the stream
+	 * @param key         key of the object in the historized send group
+	 * @param start       first stream entry id or millisecond server time to
+	 * read ("-" for the oldest sample, "(" + id to start after an id). The
+	 * server time is a Unix time, like the timestamps of the samples, and
+	 * matches them as well as the sender and server clocks are synchronized.
+	 * @param end         last stream entry id or millisecond server time to
+	 * read ("+" for the newest sample)
+	 * @param count       maximum number of samples to read (0 for no limit)
+	 * @return            the samples of the key
+	 */
+	History getHistory(const std::string& stream_key, const std::string& key,
+					   const std::string& start = "-",
+					   const std::string& end = "+", const size_t count = 0);
+
+	/**
+	 * @brief Performs sendAllFromGroup and receiveAllFromGroup in a single
+	 * round trip to the redis server: the MSET and the MGET are pipelined
+	 * and both replies are read afterwards. The values are sent before being
+	 * read, so a key present in both groups reads back the value just sent.
+	 *
+	 * @param send_group_name     name of the group that contains the objects
+	 * to send
+	 * @param receive_group_name  name of the group that contains the objects
+	 * to update
+	 * @return GROUP_OK, or GROUP_DISCONNECTED (see enableAutoReconnect)
+	 */
+	GroupStatus sendAndReceiveAllFromGroup(
+		const std::string& send_group_name = "default",
+		const std::string& receive_group_name = "default");
+
+	/**
+	 * @brief Performs sendAndReceiveAllFromGroup for multiple send and
+	 * receive groups with a single round trip
+	 *
+	 * @param send_group_names     vector of group names to send
+	 * @param receive_group_names  vector of group names to receive
+	 */
+	GroupStatus sendAndReceiveAllFromGroup(
+		const std::vector<std::string>& send_group_names,
+		const std::vector<std::string>& receive_group_names);
+	GroupStatus sendAndReceiveAllFromGroup(const GroupListHandle& send_groups,
+										   const GroupListHandle& receive_groups);
+
+	/**
+	 * @brief Subscribe a receive group to the keyspace notifications of its
+	 * keys, so that it can be updated only when one of its keys changes (see
+	 * receiveAllFromGroupIfUpdated). This opens an additional connection to
+	 * the server and enables the keyspace notifications for the string and
+	 * hash commands on the server ('K$h' flags of notify-keyspace-events) if
+	 * needed. Keys added to the group afterwards require calling this
+	 * function again.
+	 *
+	 * @param group_name name of the receive group to subscribe
+	 */
+	void subscribeToReceiveGroup(const std::string& group_name = "default");
+
+	/**
+	 * @brief Check, without blocking, whether one of the keys of a subscribed
+	 * receive group changed since the group was last received
+	 *
+	 * @param group_name name of the subscribed receive group
+	 * @return true if new data is available
+	 */
+	bool receiveGroupHasNewData(const std::string& group_name = "default");
+
+	/**
+	 * @brief Perform receiveAllFromGroup for a subscribed receive group only
+	 * if one of its keys changed since it was last received. Meant to be
+	 * called every cycle for groups that change much slower than the loop.
+	 *
+	 * @param group_name name of the subscribed receive group
+	 * @return true if the group was received (new data), false otherwise
+	 */
+	bool receiveAllFromGroupIfUpdated(
+		const std::string& group_name = "default");
+
+	/**
+	 * @brief Cache the values of a receive group on the client side, for
+	 * groups that are large but mostly static. The server tracks the keys
+	 * read by this client (CLIENT TRACKING, Redis 6 or newer) and sends an
+	 * invalidation message on an additional connection when one of them
+	 * changes. receiveAllFromGroup then only fetches and decodes the keys
+	 * invalidated since the last receive. The received objects must not be
+	 * modified by the application. Caching is disabled by connect() and
+	 * deleteReceiveGroup().
+	 *
+	 * @param group_name name of the receive group to cache
+	 */
+	void enableReceiveGroupCaching(const std::string& group_name = "default");
+
+	/**
+	 * @brief Buffer a receive group, so that another thread can read
+	 * consistent snapshots of its objects while it is received. The receive
+	 * functions then decode into internal copies of the objects and publish
+	 * them all at once when the whole group is decoded, without changing the
+	 * registered objects. The thread owning the registered objects updates
+	 * them with readReceiveGroupSnapshot(), which never waits for the
+	 * receiving thread, nor makes it wait. The groups must not be created,
+	 * modified or deleted while both threads use the client.
+	 *
+	 * @param group_name  name of the receive group
+	 * @param buffered    buffer the group, or go back to decoding into the
+	 * registered objects
+	 */
+	void setReceiveGroupBuffered(const std::string& group_name,
+								 const bool buffered = true);
+
+	/**
+	 * @brief Copy the last snapshot published by the receive functions of a
+	 * buffered receive group to its registered objects. Safe to call from
+	 * one thread while another receives the group.
+	 *
+	 * @param group_name  name of the buffered receive group
+	 * @return true if a new snapshot was copied, false if none was published
+	 * since the last call (the objects are then unchanged)
+	 */
+	bool readReceiveGroupSnapshot(const std::string& group_name = "default");
+
+	/**
+	 * @brief Same as readReceiveGroupSnapshot with a group name, for the
+	 * group of a handle, without any lookup of the group name
+	 */
+	bool readReceiveGroupSnapshot(const GroupHandle& group);
+
+	/**
+	 * @brief Counters of a key-value command type
+	 *
+	 * @param type  command type
+	 * @return counters living as long as the client
+	 */
+	const StatsCounters& commandStats(const CommandType type) const {
+		return _command_stats[type];
+	}
+
+	/**
+	 * @brief Counters of the sendAllFromGroup calls of a group, or of a list
+	 * of groups sent together (counted separately from the groups alone).
+	 * The counters are created on the first request if the group was never
+	 * sent, and are kept when the group is deleted.
+	 *
+	 * @param group_name  name of the send group
+	 * @return counters that a monitoring thread can keep and read
+	 */
+	std::shared_ptr<const StatsCounters> sendGroupStats(
+		const std::string& group_name = "default");
+	std::shared_ptr<const StatsCounters> sendGroupStats(
+		const std::vector<std::string>& group_names);
+
+	/**
+	 * @brief Counters of the receiveAllFromGroup calls of a group, or of a
+	 * list of groups received together (see sendGroupStats)
+	 *
+	 * @param group_name  name of the receive group
+	 * @return counters that a monitoring thread can keep and read
+	 */
+	std::shared_ptr<const StatsCounters> receiveGroupStats(
+		const std::string& group_name = "default");
+	std::shared_ptr<const StatsCounters> receiveGroupStats(
+		const std::vector<std::string>& group_names);
+
+	/**
+	 * @brief Reset the counters of all the command types and groups. Can be
+	 * called from any thread, for example by a monitoring thread, while the
+	 * client records calls. A snapshot taken during the reset can mix reset
+	 * and non reset counters.
+	 */
+	void resetStats();
+
+	/**
+	 * @brief Open an additional, non-blocking connection to the Redis server,
+	 * used by the asynchronous group functions (sendAllFromGroupAsync and
+	 * startReceiveAllFromGroup). connect() is still required for all the
+	 * other functions and to set up the groups.
+	 *
+	 * @details The asynchronous connection never blocks the calling thread.
+	 * Its I/O only progresses during the calls to the asynchronous functions
+	 * and to processAsyncEvents() or waitForAsyncReplies(), which lets a
+	 * control loop overlap the round trip to redis with its computations.
+	 * The event handling is embedded (see RedisEpollAdapter), no external
+	 * event library is needed.
+	 *
+	 * @param hostname  Redis server IP address (default 127.0.0.1), or a unix
+	 * domain socket given as "unix://<socket path>".
+	 * @param port      Redis server port number (default 6379).
+	 */
+	void connectAsync(const std::string& hostname = "127.0.0.1",
+					  const int port = 6379);
+
+	/**
+	 * @brief Asynchronous version of sendAllFromGroup. Queues the MSET on the
+	 * asynchronous connection and returns immediately. Errors are reported
+	 * by a later call to processAsyncEvents() or waitForAsyncReplies().
+	 *
+	 * @param group_name name of the group that contains the objects to send
+	 */
+	void sendAllFromGroupAsync(const std::string& group_name = "default");
+	void sendAllFromGroupAsync(const std::vector<std::string>& group_names);
+	void sendAllFromGroupAsync(const GroupListHandle& groups);
+
+	/**
+	 * @brief Asynchronous version of receiveAllFromGroup. Queues the MGET on
+	 * the asynchronous connection and returns immediately. The registered
+	 * objects are updated later, from within processAsyncEvents() or
+	 * waitForAsyncReplies(), when the reply arrives.
+	 *
+	 * @param group_name name of the group that contains the objects to update
+	 */
+	void startReceiveAllFromGroup(const std::string& group_name = "default");
+	void startReceiveAllFromGroup(const std::vector<std::string>& group_names);
+	void startReceiveAllFromGroup(const GroupListHandle& groups);
+
+	/**
+	 * @brief Handle the I/O of the asynchronous connection: write the queued
+	 * commands and process the available replies (which updates the objects
+	 * of the receive groups started with startReceiveAllFromGroup)
+	 *
+	 * @param timeout_ms  maximum time to wait for I/O in milliseconds (0 to
+	 * return immediately, -1 to wait until some I/O is handled)
+	 * @return            true if all the asynchronous requests are completed
+	 * @throws std::runtime_error if one of the completed requests failed
+	 */
+	bool processAsyncEvents(const int timeout_ms = 0);
+
+	/**
+	 * @brief Block until all the asynchronous requests are completed
+	 *
+	 * @throws std::runtime_error if one of the completed requests failed
+	 */
+	void waitForAsyncReplies();
+
+	/**
+	 * @brief Number of asynchronous requests waiting for their reply
+	 */
+	size_t pendingAsyncRequests() const { return _async_requests.size(); }
+
+	/**
+	 * Encode Eigen::MatrixXd as JSON.
+	 *
+	 * encodeEigenMatrixJSON():
+	 *   [1,2,3,4]     => "[1,2,3,4]"
+	 *   [[1,2],[3,4]] => "[[1,2],[3,4]]"
+	 *
+	 * @param matrix     Eigen::MatrixXd to encode.
+	 * @param precision  Significant digits of the coefficients, 0 for the
+	 * shortest exact representation.
+	 * @return           Encoded string.
+	 */
+	template <typename Derived>
+	static std::string encodeEigenMatrix(
+		const Eigen::MatrixBase<Derived>& matrix, const int precision = 0);
+
+	/**
+	 * Same as encodeEigenMatrix, appending to an existing string.
+	 */
+	template <typename Derived>
+	static void appendEigenMatrix(const Eigen::MatrixBase<Derived>& matrix,
+								  std::string& s, const int precision = 0);
+
+	/**
+	 * Encode an Eigen object in the binary format (see EigenEncoding).
+	 *
+	 * The coefficients are written in column major order with their own
+	 * scalar type when it is double, float, int32 or int64, and converted to
+	 * double otherwise.
+	 *
+	 * @param matrix  Eigen object to encode.
+	 * @return        Encoded binary string (may contain null bytes).
+	 */
+	template <typename Derived>
+	static std::string encodeEigenMatrixBinary(
+		const Eigen::MatrixBase<Derived>& matrix);
+
+	/**
+	 * Same as encodeEigenMatrixBinary, appending to an existing string.
+	 */
+	template <typename Derived>
+	static void appendEigenMatrixBinary(
+		const Eigen::MatrixBase<Derived>& matrix, std::string& s);
+
+	/**
+	 * Check whether a value read from redis holds a binary encoded Eigen
+	 * object, by looking for the binary header magic.
+	 *
+	 * @param str  String read from redis.
+	 * @return     true if the value is binary encoded.
+	 */
+	static bool isBinaryEncodedEigenMatrix(const std::string& str);
+
+	/**
+	 * Decode Eigen::MatrixXd from JSON or from the binary format. The format
+	 * is detected automatically.
+	 *
+	 * decodeEigenMatrixJSON():
+	 *   "[1,2,3,4]"     => [1,2,3,4]
+	 *   "[[1,2],[3,4]]" => [[1,2],[3,4]]
+	 *
+	 * @param str  String to decode.
+	 * @return     Decoded Eigen::Matrix. Optimized with RVO.
+	 */
+	static Eigen::MatrixXd decodeEigenMatrix(const std::string& str);
+
+	/**
+	 * Decode Eigen::MatrixXd from the binary format.
+	 *
+	 * @param str  String to decode, starting with the binary header.
+	 * @return     Decoded Eigen::Matrix, coefficients converted to double.
+	 */
+	static Eigen::MatrixXd decodeEigenMatrixBinary(const std::string& str);
+
+private:
+	/**
+	 * @brief Typed codec of the objects of the send and receive groups: the
+	 * functions of Codec<T> for the C++ type T of the registered objects,
+	 * behind void pointers that are only ever cast back to T. One codec is
+	 * instantiated at compile time per registered type.
+	 */
+	struct ObjectCodec {
+		// append the redis value of the object (text or binary Eigen
+		// encoding, significant digits of the doubles)
+		void (*encode)(const void* object, const EigenEncoding encoding,
+					   const int precision, std::string& value);
+		// write a value read from redis into the object
+		void (*decode)(const char* str, const size_t len, void* object);
+		// raw bytes of the value, compared by the change detection
+		void (*raw)(const void* object, const char*& data, size_t& size);
+		// the registered string itself, sent without copy, or nullptr for
+		// the other types
+		const std::string* (*string)(const void* object);
+		// packed group entry: type, shape and value (size and bytes), and
+		// decoding of a value, returning false if its size does not match
+		uint8_t packed_type;
+		void (*shape)(const void* object, int& rows, int& cols);
+		// give the object the shape of a received value, resizing dynamic
+		// size objects, or return false if it cannot take it
+		bool (*reshape)(void* object, const int rows, const int cols);
+		void (*pack)(const void* object, std::string& blob);
+		bool (*unpack)(const char* data, const size_t size, void* object);
+		// copies of the objects of the buffered receive groups
+		void* (*clone)(const void* object);
+		void (*copy)(const void* from, void* to);
+		void (*destroy)(void* object);
+	};
+
+	/**
+	 * @brief Encoding and decoding of one type of object (double, float,
+	 * int, int64_t, bool, std::string, Eigen::Matrix, Eigen::Quaternion,
+	 * Eigen::Transform, std::array<double, N> and std::vector<double>),
+	 * specialized at the end of this file
+	 */
+	template <typename T>
+	struct Codec;
+
+	/**
+	 * Get the codec of a type, instantiated on first use.
+	 */
+	template <typename T>
+	static const ObjectCodec* objectCodec();
+
+	/**
+	 * @brief An object of a send or receive group with the codec of its type
+	 */
+	struct SendObject {
+		const ObjectCodec* codec;
+		const void* object;
+	};
+	struct ReceiveObject {
+		const ObjectCodec* codec;
+		void* object;
+	};
+
+	struct SendGroup;
+	struct ReceiveGroup;
+
+	/**
+	 * Add an object of any type with a codec to a send group.
+	 */
+	template <typename T>
+	void addObjectToSendGroup(const std::string& key, const T& object,
+							  SendGroup& group);
+
+	/**
+	 * Write the current value of an object to redis and add it to a receive
+	 * group.
+	 */
+	template <typename T>
+	void addObjectToReceiveGroup(const std::string& key, T& object,
+								 ReceiveGroup& group);
+
+	/**
+	 * Throw if the transport is not a connection to a redis server, for the
+	 * features that need one.
+	 */
+	void requireServer(const std::string& feature) const;
+
+	/**
+	 * Issue a command to Redis.
+	 *
+	 * This function is a C++ wrapper around hiredis::redisCommand() that
+	 * provides a self-freeing redisReply pointer. The command is formatted in
+	 * printf() style.
+	 *
+	 * @param format  Format string.
+	 * @param ...     Format values.
+	 * @return        redisReply pointer, null if the connection failed.
+	 */
+	std::unique_ptr<redisReply, redisReplyDeleter> command(const char* format,
+														   ...);
+
+	/**
+	 * Issue a command given by its arguments (binary safe if argvlen is not
+	 * null).
+	 */
+	std::unique_ptr<redisReply, redisReplyDeleter> commandArgv(
+		const int argc, const char** argv, const size_t* argvlen);
+
+	/**
+	 * @brief A packed send group: its objects, and its blob whose header and
+	 * schema are written once, and again only when the shape of an object
+	 * changes
+	 */
+	struct PackedSendGroup {
+		std::string prefixed_key;
+		std::vector<std::string> keys;
+		std::vector<SendObject> objects;
+		std::vector<std::pair<int, int>> shapes;
+		std::string blob;
+		size_t schema_end = 0;
+	};
+
+	/**
+	 * @brief The HSET of a hash send group, with reusable arguments
+	 */
+	struct HashSendCommand {
+		std::string prefixed_key;
+		std::vector<const char*> argv;
+		std::vector<size_t> argvlen;
+	};
+
+	/**
+	 * @brief History stream of a send group, with the sequence number of the
+	 * last sample
+	 */
+	struct SendGroupHistory {
+		std::string stream_key;
+		size_t max_length;
+		long long sequence_number;
+	};
+
+	/**
+	 * @brief The XADD of a historized send group, with reusable arguments
+	 */
+	struct HistoryCommand {
+		std::string prefixed_key;
+		std::string max_length;
+		SendGroupHistory* history;
+		// field names and plan indexes of the objects of the group
+		std::vector<std::string> fields;
+		std::vector<size_t> objects;
+		std::string sequence_number;
+		std::string timestamp;
+		std::vector<const char*> argv;
+		std::vector<size_t> argvlen;
+	};
+
+	/**
+	 * @brief Last value sent of an object with change detection: its shape
+	 * and raw bytes, so that a reshape keeping the same bytes is a change
+	 */
+	struct SentValue {
+		// false until the object is sent, and again when the send failed, so
+		// that the next send writes it even if it did not change (an empty
+		// vector included)
+		bool sent = false;
+		int rows = 0;
+		int cols = 0;
+		std::string bytes;
+	};
+
+	/**
+	 * @brief A send group (or list of send groups) frozen into a flat list
+	 * of objects with reusable MSET arguments and encode buffers
+	 */
+	struct SendPlan {
+		std::vector<std::string> group_names;
+		// prefixed key of each object, or field name for the hash groups
+		std::vector<std::string> prefixed_keys;
+		std::vector<SendObject> objects;
+		std::vector<EigenEncoding> encodings;
+		int double_precision = 0;
+		std::vector<std::string> values;
+		std::vector<const char*> argv;
+		std::vector<size_t> argvlen;
+
+		// change detection: objects that are only sent when modified, with
+		// their last sent value, and forced full sends
+		std::vector<bool> detect_changes;
+		std::vector<SentValue> last_sent;
+		unsigned int full_refresh_interval = 0;
+		unsigned int sends_since_full_refresh = 0;
+
+		// packed groups, each sent as one blob after the objects above
+		std::vector<PackedSendGroup> packed_groups;
+
+		// hash groups, with the HSET of each object (-1 for the MSET)
+		std::vector<HashSendCommand> hash_commands;
+		std::vector<int> hash_command_indexes;
+
+		// historized groups
+		std::vector<HistoryCommand> history_commands;
+
+		// counters of the group or list of groups
+		std::shared_ptr<StatsCounters> stats;
+	};
+
+	/**
+	 * @brief Decoder for one object of a receive plan: the decode function of
+	 * the codec of its type, and the object
+	 */
+	struct ReceiveDecoder {
+		void (*decode)(const char* str, const size_t len, void* object);
+		void* object;
+	};
+
+	/**
+	 * @brief The HMGET of a hash receive group with the decoders of its fields
+	 */
+	struct HashReceiveCommand {
+		std::string prefixed_key;
+		std::vector<std::string> fields;
+		std::vector<const char*> argv;
+		std::vector<size_t> argvlen;
+		std::vector<ReceiveDecoder> decoders;
+	};
+
+	/**
+	 * @brief A packed receive group: its objects, and the blob entry of each
+	 * object for the last schema received
+	 */
+	struct PackedReceiveGroup {
+		std::string prefixed_key;
+		std::vector<std::string> keys;
+		std::vector<ReceiveObject> objects;
+		// header and schema of the last blob, and index in the group of the
+		// object of each entry (-1 if not received)
+		std::string schema;
+		std::vector<int> entry_objects;
+	};
+
+	/**
+	 * Write the header and schema of a packed send group blob.
+	 */
+	static void packGroupSchema(PackedSendGroup& group);
+
+	/**
+	 * Write the current values of a packed send group after its schema.
+	 */
+	static void packGroupValues(PackedSendGroup& group);
+
+	/**
+	 * Decode a packed group blob into the objects of a packed receive group.
+	 */
+	static void unpackGroup(PackedReceiveGroup& group, const char* blob,
+							const size_t len);
+
+	struct ReceiveGroupSnapshots;
+
+	/**
+	 * @brief A receive group (or list of receive groups) frozen into a cached
+	 * MGET command and a flat array of typed decoders
+	 */
+	struct ReceivePlan {
+		std::vector<std::string> group_names;
+		std::vector<std::string> prefixed_keys;
+		std::vector<const char*> argv;
+		std::vector<size_t> argvlen;
+		std::vector<ReceiveDecoder> decoders;
+
+		// packed groups, each read as one blob after the keys above
+		std::vector<PackedReceiveGroup> packed_groups;
+
+		// hash groups, each read with its own HMGET after the MGET
+		std::vector<HashReceiveCommand> hash_commands;
+
+		// buffered groups, published once all the replies are decoded
+		std::vector<std::shared_ptr<ReceiveGroupSnapshots>> snapshots;
+
+		// counters of the group or list of groups
+		std::shared_ptr<StatsCounters> stats;
+	};
+
+	/**
+	 * Get the receive plan for the given list of groups, compiling it on
+	 * first use.
+	 *
+	 * @param group_names  Pointer to the first group name.
+	 * @param num_groups   Number of groups.
+	 * @return             The cached receive plan.
+	 */
+	const std::shared_ptr<ReceivePlan>& compiledReceivePlan(
+		const std::string* group_names, const size_t num_groups);
+	const std::shared_ptr<ReceivePlan>& compiledReceivePlan(
+		ReceiveGroup& group);
+	const std::shared_ptr<ReceivePlan>& compiledReceivePlan(
+		const GroupListHandle& groups, const char* action);
+
+	/**
+	 * Freeze a list of receive groups into a new receive plan.
+	 */
+	ReceivePlan compileReceivePlan(ReceiveGroup* const* groups,
+								   const size_t num_groups) const;
+
+	/**
+	 * Issue the cached MGET (and HMGET of the hash groups) of a receive plan
+	 * and decode the replies into the registered objects.
+	 */
+	GroupStatus executeReceivePlan(ReceivePlan& plan);
+
+	/**
+	 * Decode the MGET reply of a receive plan into the registered objects.
+	 */
+	void decodeReceivePlanReply(ReceivePlan& plan, const redisReply* reply);
+
+	/**
+	 * Decode the HMGET reply of a hash receive group into its objects.
+	 */
+	static void decodeHashReply(const HashReceiveCommand& command,
+								const redisReply* reply);
+
+	/**
+	 * Queue the commands of a plan on the connection without reading the
+	 * replies, and return the number of commands queued.
+	 *
+	 * @param num_keys   Incremented by the number of keys written or read.
+	 * @param num_bytes  Incremented by the size of the arguments.
+	 */
+	size_t appendSendPlanCommands(SendPlan& plan, size_t& num_keys,
+								  size_t& num_bytes);
+	size_t appendReceivePlanCommands(ReceivePlan& plan, size_t& num_keys,
+									 size_t& num_bytes);
+
+	/**
+	 * Size of the strings of a reply, and of the last pipelined replies.
+	 */
+	static size_t replyBytes(const redisReply* reply);
+	size_t pipelineReplyBytes() const;
+
+	/**
+	 * Get the counters of a list of groups, creating them if needed.
+	 */
+	const std::shared_ptr<StatsCounters>& groupStats(
+		std::map<std::vector<std::string>, std::shared_ptr<StatsCounters>>&
+			group_stats,
+		const std::string* group_names, const size_t num_groups);
+
+	/**
+	 * Read the replies of pipelined commands into _pipeline_replies. Returns
+	 * false if the connection failed.
+	 */
+	bool readPipelineReplies(const size_t num_replies);
+
+	/**
+	 * Check the pipelined replies of the commands of a send plan, starting
+	 * at the given reply.
+	 */
+	void checkSendPlanReplies(SendPlan& plan, const size_t first_reply,
+							  const size_t num_replies);
+
+	/**
+	 * Decode the pipelined replies of the commands of a receive plan,
+	 * starting at the given reply, and publish its buffered groups.
+	 */
+	void decodeReceivePlanReplies(ReceivePlan& plan, const size_t first_reply);
+
+	/**
+	 * Get the send plan for the given list of groups, compiling it on first
+	 * use.
+	 *
+	 * @param group_names  Pointer to the first group name.
+	 * @param num_groups   Number of groups.
+	 * @return             The cached send plan, kept alive by the
+	 * asynchronous requests sending it.
+	 */
+	const std::shared_ptr<SendPlan>& compiledSendPlan(
+		const std::string* group_names, const size_t num_groups);
+	const std::shared_ptr<SendPlan>& compiledSendPlan(SendGroup& group);
+	const std::shared_ptr<SendPlan>& compiledSendPlan(
+		const GroupListHandle& groups, const char* action);
+
+	/**
+	 * Freeze a list of send groups into a new send plan.
+	 */
+	SendPlan compileSendPlan(SendGroup* const* groups,
+							 const size_t num_groups) const;
+
+	/**
+	 * Encode the current value of the i-th object of a send plan into its
+	 * buffer, reusing the buffer capacity.
+	 */
+	static void encodeSendPlanValue(SendPlan& plan, const size_t i);
+
+	/**
+	 * Whether the i-th object of a send plan changed since it was last sent,
+	 * updating its copy of the last sent value.
+	 */
+	static bool sendPlanValueChanged(SendPlan& plan, const size_t i);
+
+	/**
+	 * Encode all the values of a send plan, or only the changed ones for the
+	 * groups with change detection, and fill its MSET arguments.
+	 */
+	void encodeSendPlan(SendPlan& plan);
+
+	/**
+	 * Encode all the values of a send plan and send them with a single MSET
+	 * (and HSET per hash group).
+	 */
+	GroupStatus executeSendPlan(SendPlan& plan);
+
+	/**
+	 * Pipeline the MSET of a send plan and the MGET of a receive plan, then
+	 * read both replies and decode the received values.
+	 */
+	GroupStatus executeSendAndReceivePlans(SendPlan& send_plan,
+										   ReceivePlan& receive_plan);
+
+	/**
+	 * Subscribe the subscription connection, opened if needed, to channels
+	 * and wait for the confirmations. Only called by the setup functions,
+	 * the reconnector subscribes the connections it opens.
+	 */
+	void subscribeToChannels(const std::vector<std::string>& channels);
+
+	/**
+	 * Read the available subscription messages without blocking and flag
+	 * the subscribed groups and cached keys that changed.
+	 */
+	void processSubscriptionMessages();
+
+	/**
+	 * Handle a keyspace notification or a tracking invalidation message.
+	 */
+	void handleSubscriptionMessage(const redisReply* reply);
+
+	/**
+	 * @brief Background thread of the automatic reconnection, opening the
+	 * new connections (defined in the source file)
+	 */
+	struct Reconnector;
+
+	/**
+	 * Whether the group functions can use the connection. After a failure,
+	 * takes the new connections from the reconnector once it restored the
+	 * client state on them, without blocking nor sending anything.
+	 */
+	bool connectionReady();
+
+	/**
+	 * Mark the connection as lost and ask the reconnector for a new one,
+	 * with the client state to restore on it (see enableAutoReconnect). The
+	 * broken connections are kept until then, so that the other functions
+	 * fail immediately.
+	 */
+	void connectionLost();
+
+	/**
+	 * @brief Client side cache state of a receive group.
+	 */
+	struct CachedReceiveGroup {
+		// per key of the group, whether it must be fetched. Empty when
+		// everything must be fetched
+		std::vector<bool> stale;
+		// index in the group of each prefixed key
+		std::unordered_map<std::string, size_t> key_indexes;
+		// reused MGET arguments and indexes of the fetched keys
+		std::vector<const char*> argv;
+		std::vector<size_t> argvlen;
+		std::vector<size_t> fetched;
+	};
+
+	/**
+	 * @brief Snapshots of a buffered receive group. The plans decode into
+	 * staging copies of the objects, which are then copied to the back copy
+	 * of a triple buffer and published by exchanging it with the middle copy.
+	 * The reading thread takes the middle copy in exchange for its front copy
+	 * and copies it to the registered objects. Neither side ever waits.
+	 */
+	struct ReceiveGroupSnapshots {
+		~ReceiveGroupSnapshots();
+
+		std::vector<ReceiveObject> staging;
+		std::array<std::vector<ReceiveObject>, 3> copies;
+		// copy written by the receiving thread, and read by the reading one
+		int back = 0;
+		int front = 1;
+		// middle copy, with NEW_SNAPSHOT until the reading thread takes it
+		std::atomic<int> middle{2};
+		static constexpr int NEW_SNAPSHOT = 4;
+	};
+
+	/**
+	 * Create the snapshots of a buffered receive group, copies of its objects.
+	 */
+	static std::shared_ptr<ReceiveGroupSnapshots> createReceiveGroupSnapshots(
+		const std::vector<ReceiveObject>& objects);
+
+	/**
+	 * Publish the staging copies of the buffered groups of a receive plan.
+	 */
+	static void publishReceiveSnapshots(const ReceivePlan& plan);
+
+	/**
+	 * Copy the last published snapshot of a buffered receive group to its
+	 * objects, returning false if there is no new one.
+	 */
+	static bool readReceiveGroupSnapshot(ReceiveGroup& group);
+
+	/**
+	 * @brief A send group: its objects and settings, and its plan. The groups
+	 * are stored in slots indexed by the group handles, and a slot is reused
+	 * with a new generation after its group is deleted.
+	 */
+	struct SendGroup {
+		std::string name;
+		uint32_t generation = 0;
+		bool in_use = false;
+		std::vector<std::string> keys;
+		std::vector<SendObject> objects;
+		// change detection, with its full refresh interval
+		bool detect_changes = false;
+		unsigned int full_refresh_interval = 0;
+		// key of the blob if packed, of the hash if stored in a hash
+		std::string packed_key;
+		std::string hash_key;
+		// history stream if historized, kept at the same address for the
+		// plans
+		std::unique_ptr<SendGroupHistory> history;
+		// plan of the group alone, compiled on first use
+		std::shared_ptr<SendPlan> plan;
+	};
+
+	/**
+	 * @brief A receive group: its objects and settings, and its plan, stored
+	 * as the send groups
+	 */
+	struct ReceiveGroup {
+		std::string name;
+		uint32_t generation = 0;
+		bool in_use = false;
+		std::vector<std::string> keys;
+		std::vector<ReceiveObject> objects;
+		// key of the blob if packed, of the hash if read from a hash
+		std::string packed_key;
+		std::string hash_key;
+		// keyspace notifications: subscribed, and new data flag
+		bool subscribed = false;
+		bool has_new_data = false;
+		// client side caching state if cached
+		std::unique_ptr<CachedReceiveGroup> cache;
+		// snapshots if buffered, shared with the plans
+		std::shared_ptr<ReceiveGroupSnapshots> snapshots;
+		// plan of the group alone, compiled on first use
+		std::shared_ptr<ReceivePlan> plan;
+	};
+
+	/**
+	 * Get a group by name or by handle, or throw with a message ending with
+	 * "cannot <action>" if there is no such group.
+	 */
+	SendGroup& sendGroup(const std::string& group_name, const char* action);
+	SendGroup& sendGroup(const GroupHandle& group, const char* action);
+	ReceiveGroup& receiveGroup(const std::string& group_name,
+							   const char* action);
+	ReceiveGroup& receiveGroup(const GroupHandle& group, const char* action);
+
+	/**
+	 * Index of the list of those groups in the send or receive group lists,
+	 * added if needed. Throws if one of the handles is invalid.
+	 */
+	uint32_t sendGroupListIndex(const std::vector<GroupHandle>& groups);
+	uint32_t receiveGroupListIndex(const std::vector<GroupHandle>& groups);
+
+	/**
+	 * Get the receive group of a handle, or nullptr if it was deleted.
+	 */
+	ReceiveGroup* findReceiveGroup(const GroupHandle& group);
+
+	/**
+	 * Drop all the compiled send or receive plans, after a change of the
+	 * groups or of the settings.
+	 */
+	void clearSendPlans();
+	void clearReceivePlans();
+
+	/**
+	 * Fetch and decode the invalidated keys of a cached receive group.
+	 */
+	GroupStatus receiveCachedGroup(ReceiveGroup& group);
+
+	/**
+	 * @brief A request waiting for its reply on the asynchronous connection.
+	 * Holds the receive plan to decode the reply into, null for a send.
+	 */
+	struct AsyncRequest {
+		// send plan whose values the request writes, its change detection is
+		// reset if the request fails
+		std::shared_ptr<SendPlan> send_plan;
+		std::shared_ptr<ReceivePlan> receive_plan;
+		// hash group of the receive plan read by the request, -1 for the MGET
+		int hash_command;
+	};
+
+	/**
+	 * Queue the MSET of a send plan or the MGET of a receive plan on the
+	 * asynchronous connection.
+	 */
+	void executeSendPlanAsync(const std::shared_ptr<SendPlan>& plan);
+	void executeReceivePlanAsync(const std::shared_ptr<ReceivePlan>& plan);
+
+	/**
+	 * Queue a command on the asynchronous connection.
+	 */
+	void issueAsyncCommand(std::vector<const char*>& argv,
+						   const std::vector<size_t>& argvlen,
+						   AsyncRequest request);
+
+	/**
+	 * hiredis callbacks of the asynchronous connection.
+	 */
+	static void asyncReplyCallback(redisAsyncContext* ac, void* reply,
+								   void* privdata);
+	static void asyncConnectCallback(const redisAsyncContext* ac,
+									 const int status);
+	static void asyncDisconnectCallback(const redisAsyncContext* ac,
+										const int status);
+
+	/**
+	 * Append a double to a string, with the given number of significant
+	 * digits or, if 0, with the shortest representation that reads back to
+	 * the same value.
+	 */
+	static void appendDouble(std::string& str, const double value,
+							 const int precision = 0);
+
+	/**
+	 * Append a coefficient of an Eigen object with its own scalar type:
+	 * floats with the shortest representation of the float itself, integers
+	 * exactly, and the other scalars as doubles.
+	 */
+	template <typename Scalar>
+	static void appendScalar(std::string& str, const Scalar value,
+							 const int precision = 0);
+
+	/**
+	 * Decode an Eigen object (JSON or binary) in place into column major
+	 * storage of known shape, without allocating. Used by receive groups to
+	 * write straight into the registered object. The coefficients are read
+	 * as the scalar type of the storage, without going through double for
+	 * the float and integer ones.
+	 *
+	 * @param str   Pointer to the value read from redis.
+	 * @param len   Length of the value.
+	 * @param data  Column major storage of the target object.
+	 * @param rows  Number of rows of the target object.
+	 * @param cols  Number of columns of the target object.
+	 * @throws std::runtime_error if the value is malformed or its shape does
+	 * not match rows x cols (vectors are accepted in either orientation).
+	 */
+	static void decodeEigenMatrixInto(const char* str, const size_t len,
+									  double* data, const int rows,
+									  const int cols);
+	static void decodeEigenMatrixInto(const char* str, const size_t len,
+									  float* data, const int rows,
+									  const int cols);
+	static void decodeEigenMatrixInto(const char* str, const size_t len,
+									  int32_t* data, const int rows,
+									  const int cols);
+	static void decodeEigenMatrixInto(const char* str, const size_t len,
+									  int64_t* data, const int rows,
+									  const int cols);
+
+	/**
+	 * Read the shape of an Eigen object value (JSON or binary) without
+	 * decoding it. JSON vectors are read as column vectors.
+	 *
+	 * @return false if the value is not an Eigen object
+	 */
+	static bool eigenMatrixShape(const char* str, const size_t len, int& rows,
+								 int& cols);
+
+	/**
+	 * Parse a double or an int from a (not null terminated) buffer, without
+	 * allocating.
+	 */
+	static double parseDouble(const char* str, const size_t len);
+	static int parseInt(const char* str, const size_t len);
+	static float parseFloat(const char* str, const size_t len);
+	static int64_t parseInt64(const char* str, const size_t len);
+
+	/**
+	 * Perform Redis command: MGET key1 key2... and return the raw reply,
+	 * checked to be an array of strings, so that the values can be decoded
+	 * without copying them.
+	 *
+	 * @param keys  Vector of keys to get from Redis.
+	 * @return      redisReply pointer.
 	 */
-	void mset(const std::vector<std::pair<std::string, std::string>>& keyvals);
+	std::unique_ptr<redisReply, redisReplyDeleter> mgetReply(
+		const std::vector<std::string>& keys);
+
 
 	bool sendGroupExists(const std::string& group_name) const;
 	bool receiveGroupExists(const std::string& group_name) const;
 
 	/**
-	 * @brief redis context pointer
+	 * @brief key-value backend: connection to a redis server, or in-process
+	 * store
 	 *
 	 */
-	std::unique_ptr<redisContext, redisContextDeleter> _context;
+	std::unique_ptr<RedisTransport> _transport;
 
-	std::vector<std::string> _receive_group_names;
-	std::map<std::string, std::vector<std::string>> _keys_to_receive;
-	std::map<std::string, std::vector<void*>> _objects_to_receive;
-	std::map<std::string, std::vector<RedisSupportedTypes>>
-		_objects_to_receive_types;
+	// group slots, and slot index of each group name
+	std::vector<ReceiveGroup> _receive_groups;
+	std::unordered_map<std::string, uint32_t> _receive_group_indexes;
+	// plans of lists of several receive groups
+	std::vector<std::shared_ptr<ReceivePlan>> _receive_plans;
+	// lists of groups of the list handles, their plans are compiled on use
+	// and dropped with the other plans
+	struct ReceiveGroupList {
+		std::vector<GroupHandle> groups;
+		std::shared_ptr<ReceivePlan> plan;
+	};
+	std::vector<ReceiveGroupList> _receive_group_lists;
 
-	std::vector<std::string> _send_group_names;
-	std::map<std::string, std::vector<std::string>> _keys_to_send;
-	std::map<std::string, std::vector<const void*>> _objects_to_send;
-	std::map<std::string, std::vector<RedisSupportedTypes>>
-		_objects_to_send_types;
-	std::map<std::string, std::vector<std::pair<int, int>>>
-		_objects_to_send_sizes;
+	std::vector<SendGroup> _send_groups;
+	std::unordered_map<std::string, uint32_t> _send_group_indexes;
+	std::vector<std::shared_ptr<SendPlan>> _send_plans;
+	struct SendGroupList {
+		std::vector<GroupHandle> groups;
+		std::shared_ptr<SendPlan> plan;
+	};
+	std::vector<SendGroupList> _send_group_lists;
+	// replies of the last pipelined commands, reused from cycle to cycle
+	std::vector<std::unique_ptr<redisReply, redisReplyDeleter>>
+		_pipeline_replies;
 
 	std::string _prefix = "";
+
+	// server of the current connection, used by the additional connections
+	std::string _hostname = "127.0.0.1";
+	int _port = 6379;
+	struct timeval _timeout = {1, 500000};
+
+	// keyspace notifications: receive groups of each subscribed channel
+	std::unique_ptr<redisContext, redisContextDeleter> _subscription_context;
+	std::unordered_map<std::string, std::vector<GroupHandle>>
+		_keyspace_channel_groups;
+	long long _subscription_client_id = 0;
+
+	// client side caching
+	bool _client_tracking_enabled = false;
+
+	// automatic reconnection
+	std::unique_ptr<Reconnector> _reconnector;
+	bool _connection_lost = false;
+
+	// counters per command type, and per group or list of groups
+	std::array<StatsCounters, NUM_COMMAND_TYPES> _command_stats;
+	// the maps are only modified when a plan is compiled or counters are
+	// requested, the mutex lets resetStats() iterate them from any thread
+	std::mutex _stats_mutex;
+	std::map<std::vector<std::string>, std::shared_ptr<StatsCounters>>
+		_send_group_stats;
+	std::map<std::vector<std::string>, std::shared_ptr<StatsCounters>>
+		_receive_group_stats;
+
+	EigenEncoding _eigen_encoding = EIGEN_TEXT;
+	int _double_precision = 0;
+	std::map<std::string, EigenEncoding> _eigen_key_encodings;
+
+	// asynchronous connection. The context is declared last so that it is
+	// freed first, its callbacks use the other members.
+	std::unique_ptr<RedisEpollAdapter> _async_adapter;
+	std::deque<AsyncRequest> _async_requests;
+	std::string _async_error;
+	std::unique_ptr<redisAsyncContext, redisAsyncContextDeleter>
+		_async_context;
+};
+
+// \cond
+namespace RedisEigenBinary {
+
+// header layout: magic (4 bytes), version (1 byte), scalar type (1 byte), 2
+// reserved bytes, rows (uint32), cols (uint32). All little endian.
+constexpr char MAGIC[4] = {'\0', 'E', 'I', 'G'};
+constexpr uint8_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 16;
+
+enum ScalarType : uint8_t {
+	FLOAT64 = 0,
+	FLOAT32 = 1,
+	INT32 = 2,
+	INT64 = 3,
+};
+
+// scalar type stored on the wire for a given Eigen scalar, anything not
+// natively supported is converted to double
+template <typename Scalar>
+struct WireScalar {
+	using type = double;
+	static constexpr ScalarType id = FLOAT64;
+};
+template <>
+struct WireScalar<float> {
+	using type = float;
+	static constexpr ScalarType id = FLOAT32;
+};
+template <>
+struct WireScalar<int32_t> {
+	using type = int32_t;
+	static constexpr ScalarType id = INT32;
+};
+template <>
+struct WireScalar<int64_t> {
+	using type = int64_t;
+	static constexpr ScalarType id = INT64;
+};
+
+// copy a value to/from little endian bytes
+template <typename T>
+inline void writeLittleEndian(char* dst, const T value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	const char* src = reinterpret_cast<const char*>(&value);
+	for (size_t i = 0; i < sizeof(T); ++i) {
+		dst[i] = src[sizeof(T) - 1 - i];
+	}
+#else
+	std::memcpy(dst, &value, sizeof(T));
+#endif
+}
+
+template <typename T>
+inline T readLittleEndian(const char* src) {
+	T value;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	char* dst = reinterpret_cast<char*>(&value);
+	for (size_t i = 0; i < sizeof(T); ++i) {
+		dst[i] = src[sizeof(T) - 1 - i];
+	}
+#else
+	std::memcpy(&value, src, sizeof(T));
+#endif
+	return value;
+}
+
+inline size_t scalarSize(const uint8_t scalar_type) {
+	switch (scalar_type) {
+		case FLOAT64:
+			return sizeof(double);
+		case FLOAT32:
+			return sizeof(float);
+		case INT32:
+			return sizeof(int32_t);
+		case INT64:
+			return sizeof(int64_t);
+		default:
+			return 0;
+	}
+}
+
+// read the shape of a binary value, false if the header is invalid or the
+// length does not match it. The shape is untrusted input: it is checked
+// against the length before anything is sized from it.
+inline bool readShape(const char* str, const size_t len, uint32_t& rows,
+					  uint32_t& cols) {
+	if (len < HEADER_SIZE || std::memcmp(str, MAGIC, 4) != 0 ||
+		(uint8_t)str[4] != VERSION) {
+		return false;
+	}
+	const size_t scalar_size = scalarSize(str[5]);
+	rows = readLittleEndian<uint32_t>(str + 8);
+	cols = readLittleEndian<uint32_t>(str + 12);
+	if (scalar_size == 0 || (len - HEADER_SIZE) % scalar_size != 0 ||
+		rows > (uint32_t)std::numeric_limits<int>::max() ||
+		cols > (uint32_t)std::numeric_limits<int>::max()) {
+		return false;
+	}
+	// rows * cols == number of coefficients, without overflowing
+	const size_t size = (len - HEADER_SIZE) / scalar_size;
+	if (rows == 0 || cols == 0) return size == 0;
+	return size % rows == 0 && size / rows == cols;
+}
+
+}  // namespace RedisEigenBinary
+
+namespace RedisPackedGroup {
+
+// blob layout: header, schema, then the values.
+// header: magic (4 bytes), version (1 byte), 3 reserved bytes, number of
+// entries (uint32), schema size in bytes (uint32).
+// schema, per entry: name length (uint16), name, entry type (1 byte), rows
+// (uint32), cols (uint32).
+// values, per entry: value size in bytes (uint32), value. Numbers are stored
+// in little endian, int as int32, bool as one byte, Eigen objects (and arrays
+// and vectors of doubles) as column major float64.
+constexpr char MAGIC[4] = {'\0', 'P', 'K', 'G'};
+constexpr uint8_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 16;
+
+enum EntryType : uint8_t {
+	DOUBLE = 0,
+	INT32 = 1,
+	BOOL = 2,
+	STRING = 3,
+	EIGEN_FLOAT64 = 4,
+	FLOAT32 = 5,
+	INT64 = 6,
 };
 
+}  // namespace RedisPackedGroup
+// \endcond
+
 // Implementation must be part of header for compile time template
 // specialization
 template <typename Derived>
 std::string RedisClient::encodeEigenMatrix(
-	const Eigen::MatrixBase<Derived>& matrix) {
-	std::string s = "[";
+	const Eigen::MatrixBase<Derived>& matrix, const int precision) {
+	std::string s;
+	appendEigenMatrix(matrix, s, precision);
+	return s;
+}
+
+template <typename Scalar>
+void RedisClient::appendScalar(std::string& str, const Scalar value,
+							   const int precision) {
+	if constexpr (std::is_same<Scalar, float>::value) {
+		// shortest representation of the float itself, not of its conversion
+		// to double
+		char buffer[32];
+		auto result =
+			precision > 0
+				? std::to_chars(buffer, buffer + sizeof(buffer), value,
+								std::chars_format::general, std::min(precision, 9))
+				: std::to_chars(buffer, buffer + sizeof(buffer), value);
+		str.append(buffer, result.ptr);
+	} else if constexpr (std::is_integral<Scalar>::value &&
+						 !std::is_same<Scalar, bool>::value) {
+		char buffer[24];
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		str.append(buffer, result.ptr);
+	} else {
+		appendDouble(str, static_cast<double>(value), precision);
+	}
+}
+
+template <typename Derived>
+void RedisClient::appendEigenMatrix(const Eigen::MatrixBase<Derived>& matrix,
+									std::string& s, const int precision) {
+	s.append("[");
 	if (matrix.cols() == 1) {  // Column vector
 		// [[1],[2],[3],[4]] => "[1,2,3,4]"
 		for (int i = 0; i < matrix.rows(); ++i) {
 			if (i > 0) s.append(",");
-			s.append(std::to_string(matrix(i, 0)));
+			appendScalar(s, matrix(i, 0), precision);
 		}
 	} else {  // Matrix
 		// [[1,2,3,4]]   => "[1,2,3,4]"
@@ -454,32 +2226,80 @@ std::string RedisClient::encodeEigenMatrix(
 			if (matrix.rows() > 1) s.append("[");
 			for (int j = 0; j < matrix.cols(); ++j) {
 				if (j > 0) s.append(",");
-				s.append(std::to_string(matrix(i, j)));
+				appendScalar(s, matrix(i, j), precision);
 			}
 			// Nest arrays only if there are multiple rows
 			if (matrix.rows() > 1) s.append("]");
 		}
 	}
 	s.append("]");
+}
+
+template <typename Derived>
+std::string RedisClient::encodeEigenMatrixBinary(
+	const Eigen::MatrixBase<Derived>& matrix) {
+	std::string s;
+	appendEigenMatrixBinary(matrix, s);
 	return s;
 }
 
+template <typename Derived>
+void RedisClient::appendEigenMatrixBinary(
+	const Eigen::MatrixBase<Derived>& matrix, std::string& s) {
+	using WireScalar = RedisEigenBinary::WireScalar<typename Derived::Scalar>;
+	using WireType = typename WireScalar::type;
+
+	const size_t offset = s.size();
+	s.resize(offset + RedisEigenBinary::HEADER_SIZE +
+			 matrix.size() * sizeof(WireType));
+	char* buffer = &s[offset];
+	std::memset(buffer, 0, RedisEigenBinary::HEADER_SIZE);
+	std::memcpy(buffer, RedisEigenBinary::MAGIC, 4);
+	buffer[4] = RedisEigenBinary::VERSION;
+	buffer[5] = WireScalar::id;
+	RedisEigenBinary::writeLittleEndian<uint32_t>(buffer + 8, matrix.rows());
+	RedisEigenBinary::writeLittleEndian<uint32_t>(buffer + 12, matrix.cols());
+
+	// column major payload
+	char* payload = buffer + RedisEigenBinary::HEADER_SIZE;
+	for (int j = 0; j < matrix.cols(); ++j) {
+		for (int i = 0; i < matrix.rows(); ++i) {
+			RedisEigenBinary::writeLittleEndian<WireType>(
+				payload, static_cast<WireType>(matrix(i, j)));
+			payload += sizeof(WireType);
+		}
+	}
+}
+
 template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows,
 		  int _MaxCols>
 void RedisClient::addToReceiveGroup(
 	const std::string& key,
 	Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>& object,
 	const std::string& group_name) {
-	if (!receiveGroupExists(group_name)) {
-		throw std::runtime_error(
-			"Receive group with that name not found, cannot add object to "
-			"receive");
-	}
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
 
-	setEigen(key, object);
-	_keys_to_receive[group_name].push_back(key);
-	_objects_to_receive[group_name].push_back(object.data());
-	_objects_to_receive_types[group_name].push_back(EIGEN_OBJECT);
+template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows,
+		  int _MaxCols>
+void RedisClient::addToReceiveGroup(
+	const std::string& key,
+	Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>& object,
+	const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows,
+		  int _MaxCols>
+void RedisClient::addToSendGroup(
+	const std::string& key,
+	const Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>&
+		object,
+	const std::string& group_name) {
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
 }
 
 template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows,
@@ -488,19 +2308,676 @@ void RedisClient::addToSendGroup(
 	const std::string& key,
 	const Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>&
 		object,
+	const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
+
+template <typename _Scalar, int _Options>
+void RedisClient::addToReceiveGroup(
+	const std::string& key, Eigen::Quaternion<_Scalar, _Options>& object,
+	const std::string& group_name) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+template <typename _Scalar, int _Options>
+void RedisClient::addToReceiveGroup(
+	const std::string& key, Eigen::Quaternion<_Scalar, _Options>& object,
+	const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+void RedisClient::addToReceiveGroup(
+	const std::string& key,
+	Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+	const std::string& group_name) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+void RedisClient::addToReceiveGroup(
+	const std::string& key,
+	Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+	const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+template <size_t N>
+void RedisClient::addToReceiveGroup(const std::string& key,
+									std::array<double, N>& object,
+									const std::string& group_name) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group_name, "add object to receive"));
+}
+
+template <size_t N>
+void RedisClient::addToReceiveGroup(const std::string& key,
+									std::array<double, N>& object,
+									const GroupHandle& group) {
+	addObjectToReceiveGroup(key, object,
+							receiveGroup(group, "add object to receive"));
+}
+
+template <typename _Scalar, int _Options>
+void RedisClient::addToSendGroup(
+	const std::string& key, const Eigen::Quaternion<_Scalar, _Options>& object,
+	const std::string& group_name) {
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
+}
+
+template <typename _Scalar, int _Options>
+void RedisClient::addToSendGroup(
+	const std::string& key, const Eigen::Quaternion<_Scalar, _Options>& object,
+	const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
+
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+void RedisClient::addToSendGroup(
+	const std::string& key,
+	const Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
 	const std::string& group_name) {
-	if (!sendGroupExists(group_name)) {
-		throw std::runtime_error(
-			"Send group with that name not found, cannot add object to send");
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
+}
+
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+void RedisClient::addToSendGroup(
+	const std::string& key,
+	const Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& object,
+	const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
+
+template <size_t N>
+void RedisClient::addToSendGroup(const std::string& key,
+								 const std::array<double, N>& object,
+								 const std::string& group_name) {
+	addObjectToSendGroup(key, object,
+						 sendGroup(group_name, "add object to send"));
+}
+
+template <size_t N>
+void RedisClient::addToSendGroup(const std::string& key,
+								 const std::array<double, N>& object,
+								 const GroupHandle& group) {
+	addObjectToSendGroup(key, object, sendGroup(group, "add object to send"));
+}
+
+template <typename T>
+void RedisClient::addObjectToSendGroup(const std::string& key, const T& object,
+									   SendGroup& group) {
+	group.keys.push_back(key);
+	group.objects.push_back({objectCodec<T>(), &object});
+	clearSendPlans();
+}
+
+template <typename T>
+void RedisClient::addObjectToReceiveGroup(const std::string& key, T& object,
+										  ReceiveGroup& group) {
+	const ObjectCodec* codec = objectCodec<T>();
+	std::string value;
+	codec->encode(&object, eigenEncodingForKey(key), _double_precision, value);
+	set(key, value);
+	group.keys.push_back(key);
+	group.objects.push_back({codec, &object});
+	if (group.snapshots) {
+		group.snapshots = createReceiveGroupSnapshots(group.objects);
 	}
+	clearReceivePlans();
+}
 
-	_keys_to_send[group_name].push_back(key);
-	_objects_to_send[group_name].push_back(object.data());
-	_objects_to_send_types[group_name].push_back(EIGEN_OBJECT);
-	_objects_to_send_sizes[group_name].push_back(
-		std::make_pair(object.rows(), object.cols()));
+template <typename T>
+const RedisClient::ObjectCodec* RedisClient::objectCodec() {
+	static const ObjectCodec codec = {
+		[](const void* object, const EigenEncoding encoding,
+		   const int precision, std::string& value) {
+			Codec<T>::encode(*static_cast<const T*>(object), encoding,
+							 precision, value);
+		},
+		[](const char* str, const size_t len, void* object) {
+			Codec<T>::decode(str, len, *static_cast<T*>(object));
+		},
+		[](const void* object, const char*& data, size_t& size) {
+			Codec<T>::raw(*static_cast<const T*>(object), data, size);
+		},
+		[](const void* object) -> const std::string* {
+			if constexpr (std::is_same<T, std::string>::value) {
+				return static_cast<const std::string*>(object);
+			} else {
+				return nullptr;
+			}
+		},
+		Codec<T>::packed_type,
+		[](const void* object, int& rows, int& cols) {
+			Codec<T>::shape(*static_cast<const T*>(object), rows, cols);
+		},
+		[](void* object, const int rows, const int cols) {
+			if constexpr (Codec<T>::packed_type ==
+						  RedisPackedGroup::EIGEN_FLOAT64) {
+				return Codec<T>::reshape(*static_cast<T*>(object), rows, cols);
+			} else {
+				return rows == 0 && cols == 0;
+			}
+		},
+		[](const void* object, std::string& blob) {
+			const T& value = *static_cast<const T*>(object);
+			const size_t size = Codec<T>::packedSize(value);
+			const size_t offset = blob.size();
+			blob.resize(offset + 4 + size);
+			RedisEigenBinary::writeLittleEndian<uint32_t>(&blob[offset], size);
+			Codec<T>::pack(value, &blob[offset + 4]);
+		},
+		[](const char* data, const size_t size, void* object) {
+			return Codec<T>::unpack(data, size, *static_cast<T*>(object));
+		},
+		[](const void* object) -> void* {
+			return new T(*static_cast<const T*>(object));
+		},
+		[](const void* from, void* to) {
+			*static_cast<T*>(to) = *static_cast<const T*>(from);
+		},
+		[](void* object) { delete static_cast<T*>(object); },
+	};
+	return &codec;
 }
 
+// \cond
+template <>
+struct RedisClient::Codec<double> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::DOUBLE;
+
+	static void encode(const double& object, const EigenEncoding,
+					   const int precision, std::string& value) {
+		appendDouble(value, object, precision);
+	}
+	static void decode(const char* str, const size_t len, double& object) {
+		object = parseDouble(str, len);
+	}
+	static void raw(const double& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(&object);
+		size = sizeof(double);
+	}
+	static void shape(const double&, int& rows, int& cols) {
+		rows = 0;
+		cols = 0;
+	}
+	static size_t packedSize(const double&) { return sizeof(double); }
+	static void pack(const double& object, char* dst) {
+		RedisEigenBinary::writeLittleEndian<double>(dst, object);
+	}
+	static bool unpack(const char* src, const size_t size, double& object) {
+		if (size != sizeof(double)) return false;
+		object = RedisEigenBinary::readLittleEndian<double>(src);
+		return true;
+	}
+};
+
+template <>
+struct RedisClient::Codec<int> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::INT32;
+
+	static void encode(const int& object, const EigenEncoding, const int,
+					   std::string& value) {
+		char buffer[16];
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer), object);
+		value.append(buffer, result.ptr);
+	}
+	static void decode(const char* str, const size_t len, int& object) {
+		object = parseInt(str, len);
+	}
+	static void raw(const int& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(&object);
+		size = sizeof(int);
+	}
+	static void shape(const int&, int& rows, int& cols) {
+		rows = 0;
+		cols = 0;
+	}
+	static size_t packedSize(const int&) { return sizeof(int32_t); }
+	static void pack(const int& object, char* dst) {
+		RedisEigenBinary::writeLittleEndian<int32_t>(dst, object);
+	}
+	static bool unpack(const char* src, const size_t size, int& object) {
+		if (size != sizeof(int32_t)) return false;
+		object = RedisEigenBinary::readLittleEndian<int32_t>(src);
+		return true;
+	}
+};
+
+template <>
+struct RedisClient::Codec<bool> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::BOOL;
+
+	static void encode(const bool& object, const EigenEncoding, const int,
+					   std::string& value) {
+		value.push_back(object ? '1' : '0');
+	}
+	static void decode(const char* str, const size_t len, bool& object) {
+		object = (bool)parseInt(str, len);
+	}
+	static void raw(const bool& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(&object);
+		size = sizeof(bool);
+	}
+	static void shape(const bool&, int& rows, int& cols) {
+		rows = 0;
+		cols = 0;
+	}
+	static size_t packedSize(const bool&) { return 1; }
+	static void pack(const bool& object, char* dst) { dst[0] = object ? 1 : 0; }
+	static bool unpack(const char* src, const size_t size, bool& object) {
+		if (size != 1) return false;
+		object = src[0] != 0;
+		return true;
+	}
+};
+
+template <>
+struct RedisClient::Codec<std::string> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::STRING;
+
+	static void encode(const std::string& object, const EigenEncoding,
+					   const int, std::string& value) {
+		value.append(object);
+	}
+	static void decode(const char* str, const size_t len,
+					   std::string& object) {
+		object.assign(str, len);
+	}
+	static void raw(const std::string& object, const char*& data,
+					size_t& size) {
+		data = object.data();
+		size = object.size();
+	}
+	static void shape(const std::string&, int& rows, int& cols) {
+		rows = 0;
+		cols = 0;
+	}
+	static size_t packedSize(const std::string& object) {
+		return object.size();
+	}
+	static void pack(const std::string& object, char* dst) {
+		std::memcpy(dst, object.data(), object.size());
+	}
+	static bool unpack(const char* src, const size_t size,
+					   std::string& object) {
+		object.assign(src, size);
+		return true;
+	}
+};
+
+template <>
+struct RedisClient::Codec<float> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::FLOAT32;
+
+	static void encode(const float& object, const EigenEncoding,
+					   const int precision, std::string& value) {
+		appendScalar(value, object, precision);
+	}
+	static void decode(const char* str, const size_t len, float& object) {
+		object = parseFloat(str, len);
+	}
+	static void raw(const float& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(&object);
+		size = sizeof(float);
+	}
+	static void shape(const float&, int& rows, int& cols) {
+		rows = 0;
+		cols = 0;
+	}
+	static size_t packedSize(const float&) { return sizeof(float); }
+	static void pack(const float& object, char* dst) {
+		RedisEigenBinary::writeLittleEndian<float>(dst, object);
+	}
+	static bool unpack(const char* src, const size_t size, float& object) {
+		if (size != sizeof(float)) return false;
+		object = RedisEigenBinary::readLittleEndian<float>(src);
+		return true;
+	}
+};
+
+template <>
+struct RedisClient::Codec<int64_t> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::INT64;
+
+	static void encode(const int64_t& object, const EigenEncoding, const int,
+					   std::string& value) {
+		char buffer[24];
+		auto result = std::to_chars(buffer, buffer + sizeof(buffer), object);
+		value.append(buffer, result.ptr);
+	}
+	static void decode(const char* str, const size_t len, int64_t& object) {
+		object = parseInt64(str, len);
+	}
+	static void raw(const int64_t& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(&object);
+		size = sizeof(int64_t);
+	}
+	static void shape(const int64_t&, int& rows, int& cols) {
+		rows = 0;
+		cols = 0;
+	}
+	static size_t packedSize(const int64_t&) { return sizeof(int64_t); }
+	static void pack(const int64_t& object, char* dst) {
+		RedisEigenBinary::writeLittleEndian<int64_t>(dst, object);
+	}
+	static bool unpack(const char* src, const size_t size, int64_t& object) {
+		if (size != sizeof(int64_t)) return false;
+		object = RedisEigenBinary::readLittleEndian<int64_t>(src);
+		return true;
+	}
+};
+
+// Eigen objects keep their scalar type and storage order: both encodings
+// write the coefficients with their own scalar type, and the column major
+// objects (including all the vectors) of double, float, int32 or int64 are
+// decoded in place with that type. The other ones are decoded through a
+// buffer of the same shape, of their scalar type or of doubles for the other
+// scalars, on the stack for fixed size objects and reused from one decode to
+// the next for dynamic size ones. Dynamic size objects take the shape of the
+// received value, and are only resized when it changes.
+template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows,
+		  int _MaxCols>
+struct RedisClient::Codec<
+	Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>> {
+	using Matrix =
+		Eigen::Matrix<_Scalar, _Rows, _Cols, _Options, _MaxRows, _MaxCols>;
+	// scalar the coefficients are decoded as
+	using DecodedScalar =
+		typename RedisEigenBinary::WireScalar<_Scalar>::type;
+	// row vectors must be row major for Eigen, with the same layout
+	using DecodedMatrix =
+		Eigen::Matrix<DecodedScalar, _Rows, _Cols,
+					  (_MaxRows == 1 && _MaxCols != 1) ? Eigen::RowMajor
+													   : Eigen::ColMajor,
+					  _MaxRows, _MaxCols>;
+	static constexpr bool decoded_in_place =
+		std::is_same<_Scalar, DecodedScalar>::value &&
+		(!(_Options & Eigen::RowMajor) || _Rows == 1 || _Cols == 1);
+	static constexpr uint8_t packed_type = RedisPackedGroup::EIGEN_FLOAT64;
+
+	static void encode(const Matrix& object, const EigenEncoding encoding,
+					   const int precision, std::string& value) {
+		if (encoding == EIGEN_BINARY) {
+			appendEigenMatrixBinary(object, value);
+		} else {
+			appendEigenMatrix(object, value, precision);
+		}
+	}
+	static void decode(const char* str, const size_t len, Matrix& object) {
+		if constexpr (Matrix::SizeAtCompileTime == Eigen::Dynamic) {
+			int rows = 0, cols = 0;
+			if (eigenMatrixShape(str, len, rows, cols)) {
+				reshape(object, rows, cols);
+			}
+		}
+		if constexpr (decoded_in_place) {
+			decodeEigenMatrixInto(str, len, object.data(), object.rows(),
+								  object.cols());
+		} else if constexpr (Matrix::MaxSizeAtCompileTime != Eigen::Dynamic) {
+			DecodedMatrix buffer;
+			buffer.resize(object.rows(), object.cols());
+			decodeEigenMatrixInto(str, len, buffer.data(), object.rows(),
+								  object.cols());
+			object = buffer.template cast<_Scalar>();
+		} else {
+			thread_local Eigen::Matrix<DecodedScalar, Eigen::Dynamic,
+									   Eigen::Dynamic>
+				buffer;
+			buffer.resize(object.rows(), object.cols());
+			decodeEigenMatrixInto(str, len, buffer.data(), object.rows(),
+								  object.cols());
+			object = buffer.template cast<_Scalar>();
+		}
+	}
+	static void raw(const Matrix& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(object.data());
+		size = sizeof(_Scalar) * object.size();
+	}
+	static void shape(const Matrix& object, int& rows, int& cols) {
+		rows = object.rows();
+		cols = object.cols();
+	}
+	static bool reshape(Matrix& object, const int rows, const int cols) {
+		// vectors are accepted in either orientation
+		const bool is_vector = (rows == 1 || cols == 1) &&
+							   (object.rows() == 1 || object.cols() == 1);
+		if ((rows == object.rows() && cols == object.cols()) ||
+			(is_vector && (Eigen::Index)rows * cols == object.size())) {
+			return true;
+		}
+		if constexpr (Matrix::SizeAtCompileTime != Eigen::Dynamic) {
+			return false;
+		} else if constexpr (Matrix::IsVectorAtCompileTime) {
+			if ((rows != 1 && cols != 1) ||
+				(Matrix::MaxSizeAtCompileTime != Eigen::Dynamic &&
+				 rows * cols > Matrix::MaxSizeAtCompileTime)) {
+				return false;
+			}
+			object.resize((Eigen::Index)rows * cols);
+			return true;
+		} else {
+			if ((_Rows != Eigen::Dynamic && rows != _Rows) ||
+				(_Cols != Eigen::Dynamic && cols != _Cols) ||
+				(_MaxRows != Eigen::Dynamic && rows > _MaxRows) ||
+				(_MaxCols != Eigen::Dynamic && cols > _MaxCols)) {
+				return false;
+			}
+			object.resize(rows, cols);
+			return true;
+		}
+	}
+	static size_t packedSize(const Matrix& object) {
+		return sizeof(double) * object.size();
+	}
+	static void pack(const Matrix& object, char* dst) {
+		for (int j = 0; j < object.cols(); ++j) {
+			for (int i = 0; i < object.rows(); ++i) {
+				RedisEigenBinary::writeLittleEndian<double>(
+					dst, static_cast<double>(object(i, j)));
+				dst += sizeof(double);
+			}
+		}
+	}
+	static bool unpack(const char* src, const size_t size, Matrix& object) {
+		if (size != sizeof(double) * object.size()) return false;
+		for (int j = 0; j < object.cols(); ++j) {
+			for (int i = 0; i < object.rows(); ++i) {
+				object(i, j) = static_cast<_Scalar>(
+					RedisEigenBinary::readLittleEndian<double>(src));
+				src += sizeof(double);
+			}
+		}
+		return true;
+	}
+};
+
+// arrays and vectors of doubles are encoded as column vectors
+template <size_t N>
+struct RedisClient::Codec<std::array<double, N>> {
+	using Array = std::array<double, N>;
+	static constexpr uint8_t packed_type = RedisPackedGroup::EIGEN_FLOAT64;
+
+	static void encode(const Array& object, const EigenEncoding encoding,
+					   const int precision, std::string& value) {
+		const Eigen::Map<const Eigen::Matrix<double, N, 1>> vector(
+			object.data());
+		if (encoding == EIGEN_BINARY) {
+			appendEigenMatrixBinary(vector, value);
+		} else {
+			appendEigenMatrix(vector, value, precision);
+		}
+	}
+	static void decode(const char* str, const size_t len, Array& object) {
+		decodeEigenMatrixInto(str, len, object.data(), N, 1);
+	}
+	static void raw(const Array& object, const char*& data, size_t& size) {
+		data = reinterpret_cast<const char*>(object.data());
+		size = sizeof(double) * N;
+	}
+	static void shape(const Array&, int& rows, int& cols) {
+		rows = N;
+		cols = 1;
+	}
+	static bool reshape(Array&, const int rows, const int cols) {
+		return (rows == 1 || cols == 1) && (size_t)rows * cols == N;
+	}
+	static size_t packedSize(const Array&) { return sizeof(double) * N; }
+	static void pack(const Array& object, char* dst) {
+		for (size_t i = 0; i < N; ++i) {
+			RedisEigenBinary::writeLittleEndian<double>(
+				dst + i * sizeof(double), object[i]);
+		}
+	}
+	static bool unpack(const char* src, const size_t size, Array& object) {
+		if (size != sizeof(double) * N) return false;
+		for (size_t i = 0; i < N; ++i) {
+			object[i] = RedisEigenBinary::readLittleEndian<double>(
+				src + i * sizeof(double));
+		}
+		return true;
+	}
+};
+
+template <>
+struct RedisClient::Codec<std::vector<double>> {
+	static constexpr uint8_t packed_type = RedisPackedGroup::EIGEN_FLOAT64;
+
+	static void encode(const std::vector<double>& object,
+					   const EigenEncoding encoding, const int precision,
+					   std::string& value) {
+		const Eigen::Map<const Eigen::VectorXd> vector(object.data(),
+													   object.size());
+		if (encoding == EIGEN_BINARY) {
+			appendEigenMatrixBinary(vector, value);
+		} else {
+			appendEigenMatrix(vector, value, precision);
+		}
+	}
+	static void decode(const char* str, const size_t len,
+					   std::vector<double>& object) {
+		int rows = 0, cols = 0;
+		if (eigenMatrixShape(str, len, rows, cols)) {
+			reshape(object, rows, cols);
+		}
+		decodeEigenMatrixInto(str, len, object.data(), object.size(), 1);
+	}
+	static void raw(const std::vector<double>& object, const char*& data,
+					size_t& size) {
+		data = reinterpret_cast<const char*>(object.data());
+		size = sizeof(double) * object.size();
+	}
+	static void shape(const std::vector<double>& object, int& rows,
+					  int& cols) {
+		rows = object.size();
+		cols = 1;
+	}
+	// the vector keeps its capacity, so a size that goes down and up again
+	// does not allocate
+	static bool reshape(std::vector<double>& object, const int rows,
+						const int cols) {
+		if (rows != 1 && cols != 1) return false;
+		object.resize((size_t)rows * cols);
+		return true;
+	}
+	static size_t packedSize(const std::vector<double>& object) {
+		return sizeof(double) * object.size();
+	}
+	static void pack(const std::vector<double>& object, char* dst) {
+		for (size_t i = 0; i < object.size(); ++i) {
+			RedisEigenBinary::writeLittleEndian<double>(
+				dst + i * sizeof(double), object[i]);
+		}
+	}
+	static bool unpack(const char* src, const size_t size,
+					   std::vector<double>& object) {
+		if (size != sizeof(double) * object.size()) return false;
+		for (size_t i = 0; i < object.size(); ++i) {
+			object[i] = RedisEigenBinary::readLittleEndian<double>(
+				src + i * sizeof(double));
+		}
+		return true;
+	}
+};
+
+// quaternions are exchanged as their coefficients (x, y, z, w, in Eigen
+// storage order) and transforms as their matrix, both through the codec of
+// the underlying Eigen matrix
+template <typename _Scalar, int _Options>
+struct RedisClient::Codec<Eigen::Quaternion<_Scalar, _Options>> {
+	using Quaternion = Eigen::Quaternion<_Scalar, _Options>;
+	using CoefficientsCodec = Codec<typename Quaternion::Coefficients>;
+	static constexpr uint8_t packed_type = CoefficientsCodec::packed_type;
+
+	static void encode(const Quaternion& object, const EigenEncoding encoding,
+					   const int precision, std::string& value) {
+		CoefficientsCodec::encode(object.coeffs(), encoding, precision, value);
+	}
+	static void decode(const char* str, const size_t len, Quaternion& object) {
+		CoefficientsCodec::decode(str, len, object.coeffs());
+	}
+	static void raw(const Quaternion& object, const char*& data,
+					size_t& size) {
+		CoefficientsCodec::raw(object.coeffs(), data, size);
+	}
+	static void shape(const Quaternion& object, int& rows, int& cols) {
+		CoefficientsCodec::shape(object.coeffs(), rows, cols);
+	}
+	static bool reshape(Quaternion& object, const int rows, const int cols) {
+		return CoefficientsCodec::reshape(object.coeffs(), rows, cols);
+	}
+	static size_t packedSize(const Quaternion& object) {
+		return CoefficientsCodec::packedSize(object.coeffs());
+	}
+	static void pack(const Quaternion& object, char* dst) {
+		CoefficientsCodec::pack(object.coeffs(), dst);
+	}
+	static bool unpack(const char* src, const size_t size,
+					   Quaternion& object) {
+		return CoefficientsCodec::unpack(src, size, object.coeffs());
+	}
+};
+
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+struct RedisClient::Codec<Eigen::Transform<_Scalar, _Dim, _Mode, _Options>> {
+	using Transform = Eigen::Transform<_Scalar, _Dim, _Mode, _Options>;
+	using MatrixCodec = Codec<typename Transform::MatrixType>;
+	static constexpr uint8_t packed_type = MatrixCodec::packed_type;
+
+	static void encode(const Transform& object, const EigenEncoding encoding,
+					   const int precision, std::string& value) {
+		MatrixCodec::encode(object.matrix(), encoding, precision, value);
+	}
+	static void decode(const char* str, const size_t len, Transform& object) {
+		MatrixCodec::decode(str, len, object.matrix());
+	}
+	static void raw(const Transform& object, const char*& data, size_t& size) {
+		MatrixCodec::raw(object.matrix(), data, size);
+	}
+	static void shape(const Transform& object, int& rows, int& cols) {
+		MatrixCodec::shape(object.matrix(), rows, cols);
+	}
+	static bool reshape(Transform& object, const int rows, const int cols) {
+		return MatrixCodec::reshape(object.matrix(), rows, cols);
+	}
+	static size_t packedSize(const Transform& object) {
+		return MatrixCodec::packedSize(object.matrix());
+	}
+	static void pack(const Transform& object, char* dst) {
+		MatrixCodec::pack(object.matrix(), dst);
+	}
+	static bool unpack(const char* src, const size_t size, Transform& object) {
+		return MatrixCodec::unpack(src, size, object.matrix());
+	}
+};
+// \endcond
+
 }  // namespace SaiCommon
 
 #endif	// REDIS_CLIENT_H
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "RedisClientPool.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace SaiCommon {
+
+namespace {
+
+// client of the current thread from a pool, and how to release it
+struct ThreadClient {
+	uint64_t pool_id;
+	RedisClient* client;
+	std::function<void()> release;
+};
+
+// clients of the current thread, looked up without lock, and released when
+// the thread exits
+struct ThreadClients {
+	~ThreadClients() {
+		for (auto& entry : entries) entry.release();
+	}
+	std::vector<ThreadClient> entries;
+};
+
+thread_local ThreadClients thread_clients;
+
+}  // namespace
+
+std::atomic<uint64_t> RedisClientPool::_next_id(0);
+
+RedisClientPool::RedisClientPool(const std::string& key_namespace_prefix,
+								 const std::string& hostname, const int port,
+								 const struct timeval& timeout)
+	: _id(_next_id++),
+	  _prefix(key_namespace_prefix),
+	  _hostname(hostname),
+	  _port(port),
+	  _timeout(timeout),
+	  _active_clients(std::make_shared<ActiveClients>()) {}
+
+RedisClient& RedisClientPool::client() {
+	// fast path: this thread already has a client from this pool
+	for (const auto& entry : thread_clients.entries) {
+		if (entry.pool_id == _id) return *entry.client;
+	}
+
+	// take an idle client if any, otherwise connect a new one outside of the
+	// lock so that other threads are not blocked by the connection
+	std::unique_ptr<RedisClient> new_client;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_idle_clients.empty()) {
+			new_client = std::move(_idle_clients.back());
+			_idle_clients.pop_back();
+		}
+	}
+	if (!new_client) new_client = createClient();
+
+	RedisClient* client_ptr = new_client.get();
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		configureClient(*client_ptr);
+	}
+	{
+		std::lock_guard<std::mutex> lock(_active_clients->mutex);
+		_active_clients->clients[std::this_thread::get_id()] =
+			std::move(new_client);
+	}
+	// the pool may be destroyed before the thread exits
+	const std::weak_ptr<ActiveClients> weak_active_clients = _active_clients;
+	auto release = [weak_active_clients] {
+		if (auto active_clients = weak_active_clients.lock()) {
+			releaseActiveClient(*active_clients);
+		}
+	};
+	thread_clients.entries.push_back({_id, client_ptr, release});
+	return *client_ptr;
+}
+
+void RedisClientPool::preconnect(const size_t num_clients) {
+	size_t num_missing = 0;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_idle_clients.size() < num_clients) {
+			num_missing = num_clients - _idle_clients.size();
+		}
+	}
+
+	std::vector<std::unique_ptr<RedisClient>> new_clients;
+	for (size_t i = 0; i < num_missing; ++i) {
+		new_clients.push_back(createClient());
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	for (auto& new_client : new_clients) {
+		_idle_clients.push_back(std::move(new_client));
+	}
+}
+
+void RedisClientPool::releaseClient() {
+	auto& entries = thread_clients.entries;
+	entries.erase(std::remove_if(entries.begin(), entries.end(),
+								 [this](const ThreadClient& entry) {
+									 return entry.pool_id == _id;
+								 }),
+				  entries.end());
+	releaseActiveClient(*_active_clients);
+}
+
+void RedisClientPool::releaseActiveClient(ActiveClients& active_clients) {
+	// disconnected outside of the lock
+	std::unique_ptr<RedisClient> client;
+	std::lock_guard<std::mutex> lock(active_clients.mutex);
+	auto it = active_clients.clients.find(std::this_thread::get_id());
+	if (it == active_clients.clients.end()) return;
+	client = std::move(it->second);
+	active_clients.clients.erase(it);
+}
+
+void RedisClientPool::setEigenEncoding(
+	const RedisClient::EigenEncoding encoding) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_eigen_encoding = encoding;
+}
+
+void RedisClientPool::setEigenEncoding(
+	const std::string& key, const RedisClient::EigenEncoding encoding) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_eigen_key_encodings[key] = encoding;
+}
+
+void RedisClientPool::setDoublePrecision(const int significant_digits) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_double_precision = significant_digits;
+}
+
+size_t RedisClientPool::numActiveClients() const {
+	std::lock_guard<std::mutex> lock(_active_clients->mutex);
+	return _active_clients->clients.size();
+}
+
+size_t RedisClientPool::numIdleClients() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _idle_clients.size();
+}
+
+std::unique_ptr<RedisClient> RedisClientPool::createClient() const {
+	std::unique_ptr<RedisClient> new_client(new RedisClient(_prefix));
+	new_client->connect(_hostname, _port, _timeout);
+	return new_client;
+}
+
+void RedisClientPool::configureClient(RedisClient& client) const {
+	client.setEigenEncoding(_eigen_encoding);
+	for (const auto& key_encoding : _eigen_key_encodings) {
+		client.setEigenEncoding(key_encoding.first, key_encoding.second);
+	}
+	client.setDoublePrecision(_double_precision);
+}
+
+}  // namespace SaiCommon
@@ -0,0 +1,147 @@
+#ifndef REDIS_CLIENT_POOL_H
+#define REDIS_CLIENT_POOL_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "RedisClient.h"
+
+namespace SaiCommon {
+
+/**
+ * @brief A pool of RedisClient connections to the same Redis server, handing
+ * out one client per thread.
+ *
+ * @details A RedisClient cannot be shared between threads. The pool gives
+ * each calling thread its own client, connected with the pool settings
+ * (server, key namespace prefix and Eigen encodings), so that many threads
+ * can use get/set and their own send/receive groups concurrently without any
+ * lock. Only the first call to client() from a given thread synchronizes with
+ * the other threads. Clients can be connected in advance with preconnect() so
+ * that threads do not pay the connection on their first call.
+ *
+ * The clients are owned by the pool and live until the pool is destroyed, or
+ * the thread calls releaseClient() or exits. The objects registered in the
+ * send and receive groups of a client must outlive it, as for a single
+ * RedisClient.
+ *
+ * The groups are not shared: their objects belong to each thread, so each
+ * thread creates its groups on its own client, and only the connection and
+ * encoding settings are shared. A group setup is only paid once per thread,
+ * its send and receive plans being compiled on the first use.
+ */
+class RedisClientPool {
+public:
+	/**
+	 * @brief Construct a pool for a Redis server. No connection is made until
+	 * preconnect() or client() is called.
+	 *
+	 * @param key_namespace_prefix  prefix of all the keys of the clients
+	 * @param hostname  Redis server IP address (default 127.0.0.1), or a unix
+	 * domain socket given as "unix://<socket path>".
+	 * @param port      Redis server port number (default 6379).
+	 * @param timeout   Connection attempt timeout (default 1.5s).
+	 */
+	RedisClientPool(const std::string& key_namespace_prefix = "",
+					const std::string& hostname = "127.0.0.1",
+					const int port = 6379,
+					const struct timeval& timeout = {1, 500000});
+
+	~RedisClientPool() = default;
+
+	// disallow copy and assign
+	RedisClientPool(const RedisClientPool&) = delete;
+	RedisClientPool& operator=(const RedisClientPool&) = delete;
+
+	/**
+	 * @brief Get the client of the calling thread, creating and connecting it
+	 * on the first call from that thread (or taking a preconnected one)
+	 *
+	 * @return the client dedicated to the calling thread
+	 */
+	RedisClient& client();
+
+	/**
+	 * @brief Connect clients in advance, up to a total of num_clients idle
+	 * clients waiting to be handed out
+	 *
+	 * @param num_clients  number of idle clients to have ready
+	 */
+	void preconnect(const size_t num_clients);
+
+	/**
+	 * @brief Disconnect and destroy the client of the calling thread, if any.
+	 * The next call to client() from this thread gets a new client. Done
+	 * automatically when the thread exits.
+	 */
+	void releaseClient();
+
+	/**
+	 * @brief Set the Eigen encoding of the clients handed out after this call
+	 * (see RedisClient::setEigenEncoding)
+	 */
+	void setEigenEncoding(const RedisClient::EigenEncoding encoding);
+	void setEigenEncoding(const std::string& key,
+						  const RedisClient::EigenEncoding encoding);
+
+	/**
+	 * @brief Set the double precision of the clients handed out after this
+	 * call (see RedisClient::setDoublePrecision)
+	 */
+	void setDoublePrecision(const int significant_digits);
+
+	/**
+	 * @brief Number of clients handed out to threads
+	 */
+	size_t numActiveClients() const;
+
+	/**
+	 * @brief Number of connected clients waiting to be handed out
+	 */
+	size_t numIdleClients() const;
+
+private:
+	/// create a new client connected with the pool settings
+	std::unique_ptr<RedisClient> createClient() const;
+
+	/// apply the shared Eigen encodings and double precision to a client
+	void configureClient(RedisClient& client) const;
+
+	struct ActiveClients;
+	/// destroy the client of the calling thread, if any
+	static void releaseActiveClient(ActiveClients& active_clients);
+
+	// unique id of the pool, used in the per thread cache instead of its
+	// address which could be reused by another pool
+	const uint64_t _id;
+	static std::atomic<uint64_t> _next_id;
+
+	const std::string _prefix;
+	const std::string _hostname;
+	const int _port;
+	const struct timeval _timeout;
+
+	// clients handed out to threads, shared with the threads so that a thread
+	// exiting after the pool is destroyed does not touch it
+	struct ActiveClients {
+		std::mutex mutex;
+		std::map<std::thread::id, std::unique_ptr<RedisClient>> clients;
+	};
+	const std::shared_ptr<ActiveClients> _active_clients;
+
+	mutable std::mutex _mutex;
+	std::vector<std::unique_ptr<RedisClient>> _idle_clients;
+
+	RedisClient::EigenEncoding _eigen_encoding = RedisClient::EIGEN_TEXT;
+	std::map<std::string, RedisClient::EigenEncoding> _eigen_key_encodings;
+	int _double_precision = 0;
+};
+
+}  // namespace SaiCommon
+
+#endif	// REDIS_CLIENT_POOL_H
@@ -0,0 +1,144 @@
+#include "RedisEpollAdapter.h"
+
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#else
+#include <poll.h>
+#endif
+
+namespace SaiCommon {
+
+RedisEpollAdapter::RedisEpollAdapter() {
+#ifdef __linux__
+	_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epoll_fd < 0) {
+		throw std::runtime_error(
+			"RedisEpollAdapter: could not create epoll instance.");
+	}
+#endif
+}
+
+RedisEpollAdapter::~RedisEpollAdapter() {
+	if (_context) {
+		// the context outlives the adapter, detach from it
+		_context->ev.data = nullptr;
+		_context->ev.addRead = nullptr;
+		_context->ev.delRead = nullptr;
+		_context->ev.addWrite = nullptr;
+		_context->ev.delWrite = nullptr;
+		_context->ev.cleanup = nullptr;
+	}
+#ifdef __linux__
+	close(_epoll_fd);
+#endif
+}
+
+void RedisEpollAdapter::attach(redisAsyncContext* context) {
+	if (_context) {
+		throw std::runtime_error(
+			"RedisEpollAdapter: already attached to a context.");
+	}
+	if (context->ev.data) {
+		throw std::runtime_error(
+			"RedisEpollAdapter: context already has an event adapter.");
+	}
+
+	_context = context;
+	_registered = false;
+	_reading = false;
+	_writing = false;
+
+	context->ev.data = this;
+	context->ev.addRead = &RedisEpollAdapter::addRead;
+	context->ev.delRead = &RedisEpollAdapter::delRead;
+	context->ev.addWrite = &RedisEpollAdapter::addWrite;
+	context->ev.delWrite = &RedisEpollAdapter::delWrite;
+	context->ev.cleanup = &RedisEpollAdapter::cleanup;
+}
+
+bool RedisEpollAdapter::process(const int timeout_ms) {
+	if (!_context || (!_reading && !_writing)) return false;
+
+	bool readable = false;
+	bool writable = false;
+#ifdef __linux__
+	struct epoll_event event;
+	if (epoll_wait(_epoll_fd, &event, 1, timeout_ms) <= 0) return false;
+	readable = event.events & (EPOLLIN | EPOLLERR | EPOLLHUP);
+	writable = event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP);
+#else
+	struct pollfd pfd;
+	pfd.fd = _context->c.fd;
+	pfd.events = (_reading ? POLLIN : 0) | (_writing ? POLLOUT : 0);
+	pfd.revents = 0;
+	if (poll(&pfd, 1, timeout_ms) <= 0) return false;
+	readable = pfd.revents & (POLLIN | POLLERR | POLLHUP);
+	writable = pfd.revents & (POLLOUT | POLLERR | POLLHUP);
+#endif
+
+	// handling an event can free the context, which detaches the adapter
+	if (readable && _reading && _context) redisAsyncHandleRead(_context);
+	if (writable && _writing && _context) redisAsyncHandleWrite(_context);
+	return true;
+}
+
+void RedisEpollAdapter::addRead(void* privdata) {
+	auto adapter = static_cast<RedisEpollAdapter*>(privdata);
+	adapter->_reading = true;
+	adapter->updateEvents();
+}
+
+void RedisEpollAdapter::delRead(void* privdata) {
+	auto adapter = static_cast<RedisEpollAdapter*>(privdata);
+	adapter->_reading = false;
+	adapter->updateEvents();
+}
+
+void RedisEpollAdapter::addWrite(void* privdata) {
+	auto adapter = static_cast<RedisEpollAdapter*>(privdata);
+	adapter->_writing = true;
+	adapter->updateEvents();
+}
+
+void RedisEpollAdapter::delWrite(void* privdata) {
+	auto adapter = static_cast<RedisEpollAdapter*>(privdata);
+	adapter->_writing = false;
+	adapter->updateEvents();
+}
+
+void RedisEpollAdapter::cleanup(void* privdata) {
+	auto adapter = static_cast<RedisEpollAdapter*>(privdata);
+	adapter->_reading = false;
+	adapter->_writing = false;
+	adapter->updateEvents();
+	adapter->_context = nullptr;
+}
+
+void RedisEpollAdapter::updateEvents() {
+#ifdef __linux__
+	if (!_context) return;
+	const int fd = _context->c.fd;
+	if (!_reading && !_writing) {
+		if (_registered) {
+			epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+			_registered = false;
+		}
+		return;
+	}
+
+	struct epoll_event event = {};
+	uint32_t events = 0;
+	if (_reading) events |= EPOLLIN;
+	if (_writing) events |= EPOLLOUT;
+	event.events = events;
+	event.data.ptr = this;
+	epoll_ctl(_epoll_fd, _registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd,
+			  &event);
+	_registered = true;
+#endif
+}
+
+}  // namespace SaiCommon
@@ -0,0 +1,65 @@
+#ifndef REDIS_EPOLL_ADAPTER_H
+#define REDIS_EPOLL_ADAPTER_H
+
+#include <hiredis/async.h>
+
+namespace SaiCommon {
+
+/**
+ * @brief Minimal hiredis event adapter driving a redisAsyncContext without an
+ * external event library.
+ *
+ * @details The adapter is not a background event loop: the I/O of the
+ * attached context only progresses when process() is called, from the thread
+ * that owns the context. It uses epoll on Linux and falls back to poll() on
+ * other platforms (only one file descriptor is watched).
+ */
+class RedisEpollAdapter {
+public:
+	RedisEpollAdapter();
+	~RedisEpollAdapter();
+
+	// disallow copy and assign
+	RedisEpollAdapter(const RedisEpollAdapter&) = delete;
+	RedisEpollAdapter& operator=(const RedisEpollAdapter&) = delete;
+
+	/**
+	 * @brief Attach the adapter to an async context. Must be done before any
+	 * command or connect callback is registered on the context.
+	 *
+	 * @param context  the async context to drive
+	 */
+	void attach(redisAsyncContext* context);
+
+	/**
+	 * @brief Wait for the socket of the attached context to be ready and
+	 * handle the pending reads and writes
+	 *
+	 * @param timeout_ms  maximum time to wait in milliseconds (0 to return
+	 * immediately, -1 to wait indefinitely)
+	 * @return            true if some I/O was handled, false on timeout or if
+	 * no context is attached
+	 */
+	bool process(const int timeout_ms);
+
+private:
+	// hiredis event callbacks
+	static void addRead(void* privdata);
+	static void delRead(void* privdata);
+	static void addWrite(void* privdata);
+	static void delWrite(void* privdata);
+	static void cleanup(void* privdata);
+
+	// propagate the read/write interest to the event backend
+	void updateEvents();
+
+	redisAsyncContext* _context = nullptr;
+	int _epoll_fd = -1;
+	bool _registered = false;
+	bool _reading = false;
+	bool _writing = false;
+};
+
+}  // namespace SaiCommon
+
+#endif	// REDIS_EPOLL_ADAPTER_H
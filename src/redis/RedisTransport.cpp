@@ -0,0 +1,13 @@
+#include "RedisTransport.h"
+
+namespace SaiCommon {
+
+std::string RedisServerTransport::description() const {
+	if (_context->connection_type == REDIS_CONN_UNIX) {
+		return "unix://" + std::string(_context->unix_sock.path);
+	}
+	return std::string(_context->tcp.host) + ":" +
+		   std::to_string(_context->tcp.port);
+}
+
+}  // namespace SaiCommon
@@ -0,0 +1,108 @@
+#ifndef REDIS_TRANSPORT_H
+#define REDIS_TRANSPORT_H
+
+#include <hiredis/hiredis.h>
+
+#include <memory>
+#include <string>
+
+namespace SaiCommon {
+
+// \cond
+struct redisReplyDeleter {
+	void operator()(redisReply* r) { freeReplyObject(r); }
+};
+
+struct redisContextDeleter {
+	void operator()(redisContext* c) { redisFree(c); }
+};
+// \endcond
+
+/**
+ * @brief Key-value backend of a RedisClient: executes redis commands and
+ * returns their replies in order.
+ *
+ * @details Commands are queued with one of the append functions and their
+ * replies read with getReply(), one per command, so that several commands
+ * can be pipelined. The replies are hiredis reply objects owned by the
+ * caller, whatever the backend.
+ */
+class RedisTransport {
+public:
+	virtual ~RedisTransport() = default;
+
+	/**
+	 * @brief Queue a command given by its arguments (binary safe)
+	 *
+	 * @return REDIS_OK, or REDIS_ERR if the command could not be queued
+	 */
+	virtual int appendCommandArgv(const int argc, const char** argv,
+								  const size_t* argvlen) = 0;
+
+	/**
+	 * @brief Queue a command already formatted in the redis protocol (see
+	 * redisFormatCommand)
+	 *
+	 * @return REDIS_OK, or REDIS_ERR if the command could not be queued
+	 */
+	virtual int appendFormattedCommand(const char* command,
+									   const size_t len) = 0;
+
+	/**
+	 * @brief Read the reply of the oldest queued command
+	 *
+	 * @param reply  set to the reply, to be freed with freeReplyObject
+	 * @return REDIS_OK, or REDIS_ERR if the connection failed or no command
+	 * is pending
+	 */
+	virtual int getReply(redisReply** reply) = 0;
+
+	/**
+	 * @brief Address of the endpoint, for display
+	 */
+	virtual std::string description() const = 0;
+
+	/**
+	 * @brief The hiredis context of a connection to a redis server, or
+	 * nullptr for the backends without a server (the features needing
+	 * additional connections are then not available)
+	 */
+	virtual redisContext* context() { return nullptr; }
+};
+
+/**
+ * @brief Transport over a hiredis connection to a redis server
+ */
+class RedisServerTransport : public RedisTransport {
+public:
+	/**
+	 * @brief Take ownership of a connected context
+	 */
+	explicit RedisServerTransport(redisContext* context)
+		: _context(context) {}
+
+	int appendCommandArgv(const int argc, const char** argv,
+						  const size_t* argvlen) override {
+		return redisAppendCommandArgv(_context.get(), argc, argv, argvlen);
+	}
+
+	int appendFormattedCommand(const char* command,
+							   const size_t len) override {
+		return redisAppendFormattedCommand(_context.get(), command, len);
+	}
+
+	int getReply(redisReply** reply) override {
+		return redisGetReply(_context.get(), (void**)reply);
+	}
+
+	std::string description() const override;
+
+	redisContext* context() override { return _context.get(); }
+
+private:
+	std::unique_ptr<redisContext, redisContextDeleter> _context;
+};
+
+}  // namespace SaiCommon
+
+#endif	// REDIS_TRANSPORT_H
@@ -0,0 +1,678 @@
+#include "SharedMemoryTransport.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace SaiCommon {
+
+namespace {
+
+// "SAI-SHM" and the version of the segment layout
+constexpr uint64_t SEGMENT_MAGIC = 0x5341492d53484d02ULL;
+
+// how long to wait for another process to initialize a segment it created
+constexpr int SEGMENT_INIT_TIMEOUT_MS = 1000;
+
+// value buffers of an entry: the current one, and one for each writer of the
+// key at the same time
+constexpr uint64_t NUM_BUFFERS = 4;
+
+// how many times a reader retries a copy whose buffer was taken by a writer,
+// and a writer looks for a free buffer, before failing
+constexpr int MAX_READ_ATTEMPTS = 1000;
+constexpr int MAX_CLAIM_ATTEMPTS = 1000;
+
+// current value of an entry: present bit, index of the buffer holding the
+// value, then a version changed by every write and delete
+constexpr uint64_t PRESENT_BIT = 1;
+constexpr int BUFFER_SHIFT = 1;
+constexpr uint64_t VERSION_UNIT = 8;
+
+// state of a buffer: number of times it was claimed in the high 32 bits, id
+// of the process writing it in the low 32 bits (0 when free)
+constexpr uint64_t OWNER_MASK = 0xffffffffULL;
+constexpr uint64_t CLAIM_UNIT = 1ULL << 32;
+
+// the data area is allocated in blocks of power of two sizes, with a list of
+// the freed blocks of each size
+constexpr uint64_t MIN_BLOCK_SIZE = 16;
+constexpr size_t NUM_BLOCK_SIZES = 40;
+
+// head of a free list: offset / MIN_BLOCK_SIZE + 1 of the first block in the
+// low bits (0 for an empty list), and a counter of the changes in the high
+// bits so that a block popped and pushed back is a different head
+constexpr int FREE_COUNTER_SHIFT = 40;
+constexpr uint64_t FREE_BLOCK_MASK = (1ULL << FREE_COUNTER_SHIFT) - 1;
+
+std::string segmentPath(const std::string& name) {
+	std::string path = "/sai-" + name;
+	std::replace(path.begin() + 1, path.end(), '/', '_');
+	return path;
+}
+
+// FNV-1a, the same in all the processes whatever their standard library
+uint64_t hashName(const uint32_t type, const std::string& key,
+				  const std::string& field) {
+	uint64_t hash = 0xcbf29ce484222325ULL ^ type;
+	for (const std::string* s : {&key, &field}) {
+		for (const char c : *s) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+		}
+		hash = (hash ^ 0xff) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+uint64_t bufferIndex(const uint64_t current) {
+	return (current >> BUFFER_SHIFT) & (NUM_BUFFERS - 1);
+}
+
+// the current value of an entry after a write or delete
+uint64_t nextCurrent(const uint64_t current, const uint64_t index,
+					 const bool present) {
+	return ((current & ~(VERSION_UNIT - 1)) + VERSION_UNIT) |
+		   (index << BUFFER_SHIFT) | (present ? PRESENT_BIT : 0);
+}
+
+// a free list head pointing to another block
+uint64_t freeListHead(const uint64_t head, const uint64_t block) {
+	return (((head >> FREE_COUNTER_SHIFT) + 1) << FREE_COUNTER_SHIFT) | block;
+}
+
+// the next block of a free list is written at the start of a freed block
+std::atomic<uint64_t>& nextFreeBlock(char* block) {
+	return *reinterpret_cast<std::atomic<uint64_t>*>(block);
+}
+
+// a killed process never releases the buffer it was writing
+bool processAlive(const uint64_t pid) {
+	return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+}  // namespace
+
+// on its own cache lines, like the entries following it
+struct alignas(64) SharedMemoryStore::Header {
+	std::atomic<uint64_t> magic;
+	uint64_t num_entries;
+	uint64_t data_size;
+	std::atomic<uint64_t> data_used;
+	// freed blocks of each size, MIN_BLOCK_SIZE << i bytes
+	std::atomic<uint64_t> free_blocks[NUM_BLOCK_SIZES];
+};
+
+// name of an entry in the data area, followed by the key then the field
+struct SharedMemoryStore::Name {
+	uint64_t hash;
+	EntryType type;
+	uint32_t key_len;
+	uint32_t field_len;
+};
+
+struct SharedMemoryStore::Buffer {
+	std::atomic<uint64_t> state;
+	// block of the data area
+	std::atomic<uint64_t> offset;
+	std::atomic<uint64_t> capacity;
+	std::atomic<uint64_t> size;
+};
+
+// aligned on cache lines, so that writers of different keys do not share
+// lines
+struct alignas(64) SharedMemoryStore::Entry {
+	// offset + 1 of the name in the data area, 0 while the entry is empty
+	std::atomic<uint64_t> name;
+	std::atomic<uint64_t> current;
+	// number of present fields of a hash entry
+	std::atomic<uint64_t> num_fields;
+	Buffer buffers[NUM_BUFFERS];
+};
+
+// the segment is shared between processes, its atomics must not use locks
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+			  "SharedMemoryStore needs lock free 64 bit atomics");
+
+SharedMemoryStore::SharedMemoryStore(const std::string& name,
+									 const size_t num_entries,
+									 const size_t data_size,
+									 const mode_t mode)
+	: _name(name), _pid(getpid()) {
+	const std::string path = segmentPath(name);
+	size_t table_size = 1;
+	while (table_size < num_entries) table_size <<= 1;
+	const size_t header_size = sizeof(Header);
+	_segment_size = header_size + table_size * sizeof(Entry) + data_size;
+
+	int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, mode);
+	const bool created = fd >= 0;
+	if (created) {
+		// the mode given to shm_open is reduced by the umask. Zero filled,
+		// which is the initial state of the entries and free lists.
+		if (fchmod(fd, mode) != 0 || ftruncate(fd, _segment_size) != 0) {
+			const int error = errno;
+			close(fd);
+			shm_unlink(path.c_str());
+			throw std::runtime_error(
+				"SharedMemoryStore: Could not set up segment " + path + ": " +
+				strerror(error));
+		}
+	} else {
+		if (errno == EEXIST) fd = shm_open(path.c_str(), O_RDWR, 0);
+		if (fd < 0) {
+			throw std::runtime_error(
+				"SharedMemoryStore: Could not open segment " + path + ": " +
+				strerror(errno));
+		}
+		// the creator may not have sized it yet
+		struct stat status = {};
+		for (int i = 0; i < SEGMENT_INIT_TIMEOUT_MS; ++i) {
+			if (fstat(fd, &status) == 0 && status.st_size > 0) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		_segment_size = status.st_size;
+		if (_segment_size < header_size) {
+			close(fd);
+			throw std::runtime_error("SharedMemoryStore: Segment " + path +
+									 " was not initialized.");
+		}
+	}
+
+	_segment = mmap(nullptr, _segment_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+					fd, 0);
+	const int map_error = errno;
+	close(fd);
+	if (_segment == MAP_FAILED) {
+		_segment = nullptr;
+		throw std::runtime_error("SharedMemoryStore: Could not map segment " +
+								 path + ": " + strerror(map_error));
+	}
+	_header = static_cast<Header*>(_segment);
+
+	if (created) {
+		_header->num_entries = table_size;
+		_header->data_size = data_size;
+		_header->data_used.store(0, std::memory_order_relaxed);
+		_header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+		return;
+	}
+
+	for (int i = 0; i < SEGMENT_INIT_TIMEOUT_MS; ++i) {
+		if (_header->magic.load(std::memory_order_acquire) != 0) break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	if (_header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC ||
+		_segment_size != header_size + _header->num_entries * sizeof(Entry) +
+							 _header->data_size) {
+		munmap(_segment, _segment_size);
+		_segment = nullptr;
+		throw std::runtime_error(
+			"SharedMemoryStore: Segment " + path +
+			" was not initialized or has an incompatible layout.");
+	}
+}
+
+SharedMemoryStore::~SharedMemoryStore() {
+	if (_segment) munmap(_segment, _segment_size);
+}
+
+std::shared_ptr<SharedMemoryStore> SharedMemoryStore::open(
+	const std::string& name, const size_t num_entries, const size_t data_size,
+	const mode_t mode) {
+	static std::mutex mutex;
+	static std::map<std::string, std::weak_ptr<SharedMemoryStore>> stores;
+	std::lock_guard<std::mutex> lock(mutex);
+	std::shared_ptr<SharedMemoryStore> store = stores[name].lock();
+	if (!store) {
+		store = std::make_shared<SharedMemoryStore>(name, num_entries,
+													data_size, mode);
+		stores[name] = store;
+	}
+	return store;
+}
+
+bool SharedMemoryStore::removeSegment(const std::string& name) {
+	return shm_unlink(segmentPath(name).c_str()) == 0;
+}
+
+SharedMemoryStore::Entry* SharedMemoryStore::entries() const {
+	return reinterpret_cast<Entry*>(static_cast<char*>(_segment) +
+									sizeof(Header));
+}
+
+char* SharedMemoryStore::data() const {
+	return reinterpret_cast<char*>(entries() + _header->num_entries);
+}
+
+const SharedMemoryStore::Name& SharedMemoryStore::nameOf(
+	const uint64_t name) const {
+	return *reinterpret_cast<const Name*>(data() + name - 1);
+}
+
+uint64_t SharedMemoryStore::allocate(const size_t size, uint64_t& capacity) {
+	size_t size_class = 0;
+	while (size_class < NUM_BLOCK_SIZES &&
+		   (MIN_BLOCK_SIZE << size_class) < size) {
+		++size_class;
+	}
+	if (size_class == NUM_BLOCK_SIZES) {
+		throw std::runtime_error("SharedMemoryStore: Cannot allocate " +
+								 std::to_string(size) + " bytes in store " +
+								 _name + ".");
+	}
+	capacity = MIN_BLOCK_SIZE << size_class;
+
+	// the next block read from a block popped meanwhile by another writer is
+	// garbage, but the head then changed and the swap fails
+	std::atomic<uint64_t>& free_blocks = _header->free_blocks[size_class];
+	uint64_t head = free_blocks.load(std::memory_order_acquire);
+	while (head & FREE_BLOCK_MASK) {
+		const uint64_t offset =
+			((head & FREE_BLOCK_MASK) - 1) * MIN_BLOCK_SIZE;
+		const uint64_t next =
+			nextFreeBlock(data() + offset).load(std::memory_order_relaxed) &
+			FREE_BLOCK_MASK;
+		if (free_blocks.compare_exchange_weak(head, freeListHead(head, next),
+											  std::memory_order_acquire,
+											  std::memory_order_acquire)) {
+			return offset;
+		}
+	}
+
+	uint64_t offset = _header->data_used.load(std::memory_order_relaxed);
+	do {
+		// a failed allocation leaves the space to the smaller ones
+		if (offset + capacity > _header->data_size) {
+			throw std::runtime_error(
+				"SharedMemoryStore: The data area of store " + _name +
+				" is full (" + std::to_string(_header->data_size) +
+				" bytes).");
+		}
+	} while (!_header->data_used.compare_exchange_weak(
+		offset, offset + capacity, std::memory_order_relaxed));
+	return offset;
+}
+
+void SharedMemoryStore::deallocate(const uint64_t offset,
+								   const uint64_t capacity) {
+	size_t size_class = 0;
+	while ((MIN_BLOCK_SIZE << size_class) < capacity) ++size_class;
+	std::atomic<uint64_t>& free_blocks = _header->free_blocks[size_class];
+	const uint64_t block = offset / MIN_BLOCK_SIZE + 1;
+	uint64_t head = free_blocks.load(std::memory_order_relaxed);
+	do {
+		nextFreeBlock(data() + offset)
+			.store(head & FREE_BLOCK_MASK, std::memory_order_relaxed);
+	} while (!free_blocks.compare_exchange_weak(head, freeListHead(head, block),
+												std::memory_order_release,
+												std::memory_order_relaxed));
+}
+
+bool SharedMemoryStore::matches(const uint64_t name, const EntryType type,
+								const uint64_t hash, const std::string& key,
+								const std::string& field) const {
+	const Name& record = nameOf(name);
+	if (record.hash != hash || record.type != type ||
+		record.key_len != key.size() || record.field_len != field.size()) {
+		return false;
+	}
+	const char* chars = reinterpret_cast<const char*>(&record + 1);
+	return memcmp(chars, key.data(), key.size()) == 0 &&
+		   memcmp(chars + key.size(), field.data(), field.size()) == 0;
+}
+
+SharedMemoryStore::Entry* SharedMemoryStore::find(
+	const EntryType type, const std::string& key,
+	const std::string& field) const {
+	const uint64_t hash = hashName(type, key, field);
+	const uint64_t mask = _header->num_entries - 1;
+	for (uint64_t i = 0; i <= mask; ++i) {
+		Entry& entry = entries()[(hash + i) & mask];
+		const uint64_t name = entry.name.load(std::memory_order_acquire);
+		if (name == 0) return nullptr;
+		if (matches(name, type, hash, key, field)) return &entry;
+	}
+	return nullptr;
+}
+
+SharedMemoryStore::Entry& SharedMemoryStore::findOrInsert(
+	const EntryType type, const std::string& key, const std::string& field) {
+	const uint64_t hash = hashName(type, key, field);
+	const uint64_t mask = _header->num_entries - 1;
+	// the name is written before it is published in an entry with a single
+	// swap, so that an entry is either empty or complete whatever happens to
+	// the process inserting it. A name not published is freed.
+	uint64_t name = 0;
+	uint64_t name_capacity = 0;
+	for (uint64_t i = 0; i <= mask; ++i) {
+		Entry& entry = entries()[(hash + i) & mask];
+		uint64_t entry_name = entry.name.load(std::memory_order_acquire);
+		if (entry_name == 0) {
+			if (name == 0) {
+				const uint64_t offset =
+					allocate(sizeof(Name) + key.size() + field.size(),
+							 name_capacity);
+				Name* record = reinterpret_cast<Name*>(data() + offset);
+				record->hash = hash;
+				record->type = type;
+				record->key_len = key.size();
+				record->field_len = field.size();
+				char* chars = reinterpret_cast<char*>(record + 1);
+				memcpy(chars, key.data(), key.size());
+				memcpy(chars + key.size(), field.data(), field.size());
+				name = offset + 1;
+			}
+			if (entry.name.compare_exchange_strong(entry_name, name,
+												   std::memory_order_acq_rel,
+												   std::memory_order_acquire)) {
+				return entry;
+			}
+		}
+		if (matches(entry_name, type, hash, key, field)) {
+			if (name != 0) deallocate(name - 1, name_capacity);
+			return entry;
+		}
+	}
+	if (name != 0) deallocate(name - 1, name_capacity);
+	throw std::runtime_error("SharedMemoryStore: The table of store " + _name +
+							 " is full (" +
+							 std::to_string(_header->num_entries) +
+							 " keys and hash fields).");
+}
+
+SharedMemoryStore::Buffer& SharedMemoryStore::claim(Entry& entry) {
+	for (int attempt = 0; attempt < MAX_CLAIM_ATTEMPTS; ++attempt) {
+		const uint64_t current = entry.current.load(std::memory_order_acquire);
+		for (uint64_t i = 0; i < NUM_BUFFERS; ++i) {
+			if (i == bufferIndex(current)) continue;
+			Buffer& buffer = entry.buffers[i];
+			uint64_t state = buffer.state.load(std::memory_order_relaxed);
+			// the buffers of killed writers are taken over when no buffer is
+			// free
+			const uint64_t owner = state & OWNER_MASK;
+			if (owner != 0 && (attempt == 0 || processAlive(owner))) continue;
+			if (!buffer.state.compare_exchange_strong(
+					state, ((state & ~OWNER_MASK) + CLAIM_UNIT) | _pid,
+					std::memory_order_acquire, std::memory_order_relaxed)) {
+				continue;
+			}
+			std::atomic_thread_fence(std::memory_order_release);
+			// the previous writer of the buffer may have published it since
+			// the current buffer was read
+			if (bufferIndex(entry.current.load(std::memory_order_acquire)) !=
+				i) {
+				return buffer;
+			}
+			release(buffer);
+		}
+		std::this_thread::yield();
+	}
+	throw std::runtime_error(
+		"SharedMemoryStore: Too many concurrent writers of a key in store " +
+		_name + ".");
+}
+
+void SharedMemoryStore::release(Buffer& buffer) {
+	buffer.state.fetch_and(~OWNER_MASK, std::memory_order_release);
+}
+
+bool SharedMemoryStore::readValue(const Entry& entry,
+								  std::string& value) const {
+	for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt) {
+		const uint64_t current = entry.current.load(std::memory_order_acquire);
+		if (!(current & PRESENT_BIT)) return false;
+		// a buffer still current after its state is read can only be written
+		// after a new claim
+		const Buffer& buffer = entry.buffers[bufferIndex(current)];
+		const uint64_t state = buffer.state.load(std::memory_order_acquire);
+		if (entry.current.load(std::memory_order_relaxed) != current) continue;
+
+		const uint64_t offset = buffer.offset.load(std::memory_order_relaxed);
+		// the size and block of a buffer taken by a writer during the copy
+		// may not match, the copy is then discarded but must stay within the
+		// data area
+		const uint64_t size =
+			std::min(buffer.size.load(std::memory_order_relaxed),
+					 buffer.capacity.load(std::memory_order_relaxed));
+		if (offset + size > _header->data_size) continue;
+		value.assign(data() + offset, size);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if ((buffer.state.load(std::memory_order_relaxed) & ~OWNER_MASK) ==
+			(state & ~OWNER_MASK)) {
+			return true;
+		}
+	}
+	throw std::runtime_error(
+		"SharedMemoryStore: Could not read a value of store " + _name +
+		", its buffers are rewritten during every copy.");
+}
+
+bool SharedMemoryStore::read(const std::string& key, const std::string* field,
+							 std::string& value) const {
+	const Entry* entry =
+		field ? find(FIELD_ENTRY, key, *field) : find(STRING_ENTRY, key, "");
+	return entry && readValue(*entry, value);
+}
+
+bool SharedMemoryStore::write(const std::string& key, const std::string* field,
+							  const char* value, const size_t len,
+							  const bool only_if_absent) {
+	// the hash entry is created first, a full table then fails before the
+	// field is written
+	Entry* hash = field ? &findOrInsert(HASH_ENTRY, key, "") : nullptr;
+	Entry& entry = field ? findOrInsert(FIELD_ENTRY, key, *field)
+						 : findOrInsert(STRING_ENTRY, key, "");
+	if (only_if_absent &&
+		(entry.current.load(std::memory_order_acquire) & PRESENT_BIT)) {
+		return false;
+	}
+
+	Buffer& buffer = claim(entry);
+	uint64_t offset = buffer.offset.load(std::memory_order_relaxed);
+	const uint64_t capacity = buffer.capacity.load(std::memory_order_relaxed);
+	if (capacity < len) {
+		const uint64_t old_offset = offset;
+		uint64_t new_capacity = 0;
+		try {
+			offset = allocate(len, new_capacity);
+		} catch (...) {
+			release(buffer);
+			throw;
+		}
+		// a writer killed before freeing the old block only leaks it
+		buffer.offset.store(offset, std::memory_order_relaxed);
+		buffer.capacity.store(new_capacity, std::memory_order_relaxed);
+		if (capacity > 0) deallocate(old_offset, capacity);
+	}
+	memcpy(data() + offset, value, len);
+	buffer.size.store(len, std::memory_order_relaxed);
+
+	const uint64_t index = &buffer - entry.buffers;
+	uint64_t current = entry.current.load(std::memory_order_relaxed);
+	do {
+		if (only_if_absent && (current & PRESENT_BIT)) {
+			release(buffer);
+			return false;
+		}
+	} while (!entry.current.compare_exchange_weak(
+		current, nextCurrent(current, index, true), std::memory_order_release,
+		std::memory_order_relaxed));
+	release(buffer);
+
+	const bool was_present = current & PRESENT_BIT;
+	if (hash && !was_present) {
+		hash->num_fields.fetch_add(1, std::memory_order_release);
+	}
+	return !was_present;
+}
+
+bool SharedMemoryStore::clear(Entry& entry) {
+	uint64_t current = entry.current.load(std::memory_order_relaxed);
+	do {
+		if (!(current & PRESENT_BIT)) return false;
+	} while (!entry.current.compare_exchange_weak(
+		current, nextCurrent(current, bufferIndex(current), false),
+		std::memory_order_release, std::memory_order_relaxed));
+	return true;
+}
+
+bool SharedMemoryStore::remove(const std::string& key) {
+	bool removed = false;
+	if (Entry* entry = find(STRING_ENTRY, key, "")) removed = clear(*entry);
+
+	// the fields of a hash are spread over the table, deleting a hash is slow
+	Entry* hash = find(HASH_ENTRY, key, "");
+	if (hash && hash->num_fields.load(std::memory_order_acquire) > 0) {
+		for (uint64_t i = 0; i < _header->num_entries; ++i) {
+			Entry& entry = entries()[i];
+			const uint64_t name = entry.name.load(std::memory_order_acquire);
+			if (name == 0) continue;
+			const Name& record = nameOf(name);
+			if (record.type != FIELD_ENTRY || record.key_len != key.size() ||
+				memcmp(&record + 1, key.data(), key.size()) != 0) {
+				continue;
+			}
+			if (clear(entry)) {
+				hash->num_fields.fetch_sub(1, std::memory_order_release);
+				removed = true;
+			}
+		}
+	}
+	return removed;
+}
+
+bool SharedMemoryStore::exists(const std::string& key) const {
+	const Entry* entry = find(STRING_ENTRY, key, "");
+	if (entry && (entry->current.load(std::memory_order_acquire) &
+				  PRESENT_BIT)) {
+		return true;
+	}
+	const Entry* hash = find(HASH_ENTRY, key, "");
+	return hash && hash->num_fields.load(std::memory_order_acquire) > 0;
+}
+
+void SharedMemoryStore::forEach(
+	const std::function<void(const std::string& key, const std::string* field,
+							 const std::string& value)>& function) const {
+	std::string key, field, value;
+	for (uint64_t i = 0; i < _header->num_entries; ++i) {
+		const Entry& entry = entries()[i];
+		const uint64_t name = entry.name.load(std::memory_order_acquire);
+		if (name == 0) continue;
+		const Name& record = nameOf(name);
+		if (record.type == HASH_ENTRY || !readValue(entry, value)) continue;
+		const char* chars = reinterpret_cast<const char*>(&record + 1);
+		key.assign(chars, record.key_len);
+		if (record.type == FIELD_ENTRY) {
+			field.assign(chars + record.key_len, record.field_len);
+			function(key, &field, value);
+		} else {
+			function(key, nullptr, value);
+		}
+	}
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string& name,
+											 const size_t num_entries,
+											 const size_t data_size,
+											 const mode_t mode)
+	: StoreTransport(
+		  SharedMemoryStore::open(name, num_entries, data_size, mode),
+		  "shm://" + name),
+	  _store(SharedMemoryStore::open(name)) {}
+
+SharedMemoryTransport::~SharedMemoryTransport() { stopMirror(); }
+
+void SharedMemoryTransport::mirrorToServer(const std::string& hostname,
+										   const int port,
+										   const int period_ms) {
+	stopMirror();
+	_mirror_stop = false;
+	_mirror_thread = std::thread(&SharedMemoryTransport::mirrorLoop, this,
+								 hostname, port, period_ms);
+}
+
+void SharedMemoryTransport::stopMirror() {
+	if (!_mirror_thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(_mirror_mutex);
+		_mirror_stop = true;
+	}
+	_mirror_stop_cv.notify_all();
+	_mirror_thread.join();
+}
+
+void SharedMemoryTransport::mirrorLoop(const std::string hostname,
+									   const int port, const int period_ms) {
+	const std::string unix_prefix = "unix://";
+	const struct timeval timeout = {1, 500000};
+	std::unique_ptr<redisContext, redisContextDeleter> context;
+	std::vector<const char*> argv;
+	std::vector<size_t> argvlen;
+
+	std::unique_lock<std::mutex> lock(_mirror_mutex);
+	while (!_mirror_stop) {
+		lock.unlock();
+		if (!context) {
+			if (hostname.compare(0, unix_prefix.size(), unix_prefix) == 0) {
+				context.reset(redisConnectUnixWithTimeout(
+					hostname.substr(unix_prefix.size()).c_str(), timeout));
+			} else {
+				context.reset(
+					redisConnectWithTimeout(hostname.c_str(), port, timeout));
+			}
+			if (context && context->err) context.reset();
+		}
+
+		if (context) {
+			// pipeline one SET or HSET per value, then read all the replies
+			size_t num_commands = 0;
+			try {
+				_store->forEach([&](const std::string& key,
+									const std::string* field,
+									const std::string& value) {
+					argv.assign({field ? "HSET" : "SET", key.data()});
+					argvlen.assign(
+						{field ? size_t(4) : size_t(3), key.size()});
+					if (field) {
+						argv.push_back(field->data());
+						argvlen.push_back(field->size());
+					}
+					argv.push_back(value.data());
+					argvlen.push_back(value.size());
+					redisAppendCommandArgv(context.get(), argv.size(),
+										   argv.data(), argvlen.data());
+					++num_commands;
+				});
+			} catch (const std::runtime_error&) {
+				// a value rewritten during every copy, the next ones are
+				// copied the next period
+			}
+			for (size_t i = 0; i < num_commands; ++i) {
+				redisReply* reply = nullptr;
+				if (redisGetReply(context.get(), (void**)&reply) != REDIS_OK) {
+					// retried with a new connection the next period
+					context.reset();
+					break;
+				}
+				freeReplyObject(reply);
+			}
+		}
+
+		lock.lock();
+		_mirror_stop_cv.wait_for(lock, std::chrono::milliseconds(period_ms),
+								 [this] { return _mirror_stop; });
+	}
+}
+
+}  // namespace SaiCommon
@@ -0,0 +1,218 @@
+#ifndef SHARED_MEMORY_TRANSPORT_H
+#define SHARED_MEMORY_TRANSPORT_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "StoreTransport.h"
+
+namespace SaiCommon {
+
+/**
+ * @brief Key-value store in a POSIX shared memory segment, shared by the
+ * processes of a machine opening the same name. Holds string keys and hash
+ * fields.
+ *
+ * @details The segment holds a fixed size open addressing table of entries
+ * and a data area where the names and values are allocated. An entry is
+ * inserted by publishing its complete name with a single compare and swap,
+ * and is never removed (a deleted key is only marked absent). Each entry has
+ * four value buffers: a writer takes a buffer not holding the current value,
+ * writes it, and publishes it by swapping the index of the current buffer,
+ * so that writers of the same key do not wait for each other. Readers copy
+ * the current buffer without any lock and retry if a writer took it during
+ * the copy. A writer only waits when the three other buffers of its key are
+ * being written, and a read or write fails if it cannot complete after a
+ * bounded number of retries. The data area is allocated in blocks of power
+ * of two sizes, and the block of a value that grows is reused by the next
+ * allocation of its size. When the table or data area is full, the writes
+ * of new keys or larger values fail.
+ *
+ * A process killed in the middle of a write keeps the buffer it was writing
+ * until another writer of the key needs it and finds the process gone, which
+ * requires the processes to share a pid namespace. The key stays readable
+ * and writable, and at most the block being replaced is leaked.
+ */
+class SharedMemoryStore : public KeyValueStore {
+public:
+	static constexpr size_t DEFAULT_NUM_ENTRIES = 1 << 14;
+	static constexpr size_t DEFAULT_DATA_SIZE = 64 << 20;
+	// only the user creating the segment can use it: any process able to
+	// write it can inject values in the exchange
+	static constexpr mode_t DEFAULT_MODE = 0600;
+
+	/**
+	 * @brief Open the segment of the given name, created with the given
+	 * sizes and permissions if it does not exist yet. The segment persists
+	 * when all the processes close it, like a server keeps its data when the
+	 * clients disconnect.
+	 *
+	 * @param name         name of the store, the segment is "/sai-<name>"
+	 * @param num_entries  maximum number of keys and hash fields, rounded up
+	 * to a power of two
+	 * @param data_size    size in bytes of the area holding the names and
+	 * values
+	 * @param mode         permissions of the segment, set regardless of the
+	 * umask. 0600 by default, 0660 to share it with the processes of other
+	 * users of the same group.
+	 */
+	SharedMemoryStore(const std::string& name,
+					  const size_t num_entries = DEFAULT_NUM_ENTRIES,
+					  const size_t data_size = DEFAULT_DATA_SIZE,
+					  const mode_t mode = DEFAULT_MODE);
+	~SharedMemoryStore() override;
+
+	// disallow copy and assign
+	SharedMemoryStore(const SharedMemoryStore&) = delete;
+	SharedMemoryStore& operator=(const SharedMemoryStore&) = delete;
+
+	/**
+	 * @brief Get the store of the given name, shared by all the transports
+	 * of the process using it. The sizes and mode are only used if the
+	 * segment does not exist yet.
+	 */
+	static std::shared_ptr<SharedMemoryStore> open(
+		const std::string& name, const size_t num_entries = DEFAULT_NUM_ENTRIES,
+		const size_t data_size = DEFAULT_DATA_SIZE,
+		const mode_t mode = DEFAULT_MODE);
+
+	/**
+	 * @brief Remove the segment of the given name. The processes having it
+	 * open keep using it, new ones create a new segment.
+	 *
+	 * @return true if the segment existed
+	 */
+	static bool removeSegment(const std::string& name);
+
+	bool read(const std::string& key, const std::string* field,
+			  std::string& value) const override;
+	bool write(const std::string& key, const std::string* field,
+			   const char* value, const size_t len,
+			   const bool only_if_absent = false) override;
+	bool remove(const std::string& key) override;
+	bool exists(const std::string& key) const override;
+
+	/**
+	 * @brief Call a function with each present key (field is null) or hash
+	 * field, and its value
+	 */
+	void forEach(const std::function<void(const std::string& key,
+										  const std::string* field,
+										  const std::string& value)>&
+					 function) const;
+
+	const std::string& name() const { return _name; }
+
+private:
+	struct Header;
+	struct Name;
+	struct Buffer;
+	struct Entry;
+
+	// a string key, a field of a hash, or a hash key counting its fields
+	enum EntryType : uint32_t { STRING_ENTRY, FIELD_ENTRY, HASH_ENTRY };
+
+	Entry* entries() const;
+	char* data() const;
+	// the name of an entry, from its offset + 1
+	const Name& nameOf(const uint64_t name) const;
+
+	// allocate a block of the data area of at least the given size, returns
+	// its offset and sets its capacity
+	uint64_t allocate(const size_t size, uint64_t& capacity);
+	// give a block back for the next allocations of its size
+	void deallocate(const uint64_t offset, const uint64_t capacity);
+
+	// the field is empty for the string and hash entries
+	Entry* find(const EntryType type, const std::string& key,
+				const std::string& field) const;
+	Entry& findOrInsert(const EntryType type, const std::string& key,
+						const std::string& field);
+	bool matches(const uint64_t name, const EntryType type,
+				 const uint64_t hash, const std::string& key,
+				 const std::string& field) const;
+
+	// copy the value of an entry, false if absent
+	bool readValue(const Entry& entry, std::string& value) const;
+
+	// take a buffer of an entry to write its next value, and give it back
+	// once the value is published
+	Buffer& claim(Entry& entry);
+	static void release(Buffer& buffer);
+
+	// mark an entry absent, false if it already was
+	static bool clear(Entry& entry);
+
+	const std::string _name;
+	// owner of the claimed buffers, read once as getpid() is a system call
+	const uint64_t _pid;
+	void* _segment = nullptr;
+	size_t _segment_size = 0;
+	Header* _header = nullptr;
+};
+
+/**
+ * @brief Transport exchanging values with the clients of all the processes
+ * of the machine using the same SharedMemoryStore, without any server or
+ * system call.
+ *
+ * @details The store can be mirrored to a redis server at a low rate, for
+ * the tools reading the keys from redis (monitoring, plotting, logging).
+ * The mirror is one way: the values set on the server are overwritten and
+ * not seen by the shared memory clients, and the keys deleted from the store
+ * stay on the server.
+ */
+class SharedMemoryTransport : public StoreTransport {
+public:
+	/**
+	 * @brief Open the store of the given name, created with the given sizes
+	 * and mode if it does not exist yet (see SharedMemoryStore)
+	 */
+	explicit SharedMemoryTransport(
+		const std::string& name,
+		const size_t num_entries = SharedMemoryStore::DEFAULT_NUM_ENTRIES,
+		const size_t data_size = SharedMemoryStore::DEFAULT_DATA_SIZE,
+		const mode_t mode = SharedMemoryStore::DEFAULT_MODE);
+	~SharedMemoryTransport() override;
+
+	/**
+	 * @brief Copy all the keys of the store to a redis server periodically,
+	 * from a background thread with its own connection. Only one of the
+	 * processes sharing the store needs to mirror it. A failed copy is
+	 * retried the next period, reconnecting to the server.
+	 *
+	 * @param hostname   server address, or "unix://<socket path>"
+	 * @param port       server port
+	 * @param period_ms  time between two copies in milliseconds
+	 */
+	void mirrorToServer(const std::string& hostname = "127.0.0.1",
+						const int port = 6379, const int period_ms = 100);
+
+	/**
+	 * @brief Stop mirroring the store to the server
+	 */
+	void stopMirror();
+
+private:
+	void mirrorLoop(const std::string hostname, const int port,
+					const int period_ms);
+
+	std::shared_ptr<SharedMemoryStore> _store;
+
+	std::thread _mirror_thread;
+	std::mutex _mirror_mutex;
+	std::condition_variable _mirror_stop_cv;
+	bool _mirror_stop = false;
+};
+
+}  // namespace SaiCommon
+
+#endif	// SHARED_MEMORY_TRANSPORT_H
@@ -0,0 +1,199 @@
+#include "StoreTransport.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace SaiCommon {
+
+namespace {
+
+// ascii case insensitive comparison of a command name
+bool isCommand(const char* arg, const size_t len, const char* name) {
+	const size_t name_len = strlen(name);
+	if (len != name_len) return false;
+	for (size_t i = 0; i < len; ++i) {
+		if (toupper(static_cast<unsigned char>(arg[i])) != name[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// parse the length of a redis protocol header ("*3\r\n" or "$5\r\n") at pos
+bool parseLength(const char* command, const size_t len, size_t& pos,
+				 const char type, size_t& value) {
+	if (pos >= len || command[pos] != type) return false;
+	value = 0;
+	for (++pos; pos < len && command[pos] != '\r'; ++pos) {
+		if (command[pos] < '0' || command[pos] > '9') return false;
+		value = 10 * value + (command[pos] - '0');
+	}
+	pos += 2;
+	return pos <= len;
+}
+
+}  // namespace
+
+StoreTransport::StoreTransport(std::shared_ptr<KeyValueStore> store,
+							   const std::string& description)
+	: _store(std::move(store)),
+	  _description(description),
+	  _reader(redisReaderCreate()) {
+	if (!_reader) {
+		throw std::runtime_error(
+			"StoreTransport: Could not allocate the reply reader.");
+	}
+}
+
+StoreTransport::~StoreTransport() { redisReaderFree(_reader); }
+
+int StoreTransport::appendCommandArgv(const int argc, const char** argv,
+									  const size_t* argvlen) {
+	if (argc < 1) return REDIS_ERR;
+	if (argvlen) {
+		execute(argc, argv, argvlen);
+	} else {
+		_argvlen.resize(argc);
+		for (int i = 0; i < argc; ++i) _argvlen[i] = strlen(argv[i]);
+		execute(argc, argv, _argvlen.data());
+	}
+	return REDIS_OK;
+}
+
+int StoreTransport::appendFormattedCommand(const char* command,
+										   const size_t len) {
+	// "*<argc>\r\n" then "$<len>\r\n<arg>\r\n" per argument
+	size_t pos = 0, argc = 0;
+	if (!parseLength(command, len, pos, '*', argc) || argc == 0) {
+		return REDIS_ERR;
+	}
+	_argv.resize(argc);
+	_argvlen.resize(argc);
+	for (size_t i = 0; i < argc; ++i) {
+		if (!parseLength(command, len, pos, '$', _argvlen[i]) ||
+			pos + _argvlen[i] + 2 > len) {
+			return REDIS_ERR;
+		}
+		_argv[i] = command + pos;
+		pos += _argvlen[i] + 2;
+	}
+	execute(argc, _argv.data(), _argvlen.data());
+	return REDIS_OK;
+}
+
+int StoreTransport::getReply(redisReply** reply) {
+	*reply = nullptr;
+	if (_num_pending == 0) return REDIS_ERR;
+	if (redisReaderGetReply(_reader, (void**)reply) != REDIS_OK || !*reply) {
+		return REDIS_ERR;
+	}
+	--_num_pending;
+	return REDIS_OK;
+}
+
+void StoreTransport::execute(const int argc, const char** argv,
+							 const size_t* argvlen) {
+	_reply.clear();
+	try {
+		reply(argc, argv, argvlen);
+	} catch (const std::exception& e) {
+		// a store that cannot hold a value, the command may be partially done
+		_reply.clear();
+		replyError(std::string("ERR ") + e.what());
+	}
+	redisReaderFeed(_reader, _reply.data(), _reply.size());
+	++_num_pending;
+}
+
+void StoreTransport::reply(const int argc, const char** argv,
+						   const size_t* argvlen) {
+	const auto arg = [&](const int i, std::string& s) -> const std::string& {
+		s.assign(argv[i], argvlen[i]);
+		return s;
+	};
+	const auto is = [&](const char* name) {
+		return isCommand(argv[0], argvlen[0], name);
+	};
+
+	if (is("PING")) {
+		replyStatus("PONG");
+	} else if (is("GET") && argc == 2) {
+		replyValue(arg(1, _key), nullptr);
+	} else if (is("SET") && (argc == 3 || argc == 4)) {
+		const bool only_if_absent =
+			argc == 4 && isCommand(argv[3], argvlen[3], "NX");
+		if (argc == 4 && !only_if_absent) {
+			replyError("ERR syntax error");
+		} else if (_store->write(arg(1, _key), nullptr, argv[2], argvlen[2],
+								 only_if_absent)) {
+			replyStatus("OK");
+		} else {
+			replyNil();
+		}
+	} else if (is("MGET") && argc >= 2) {
+		_reply.append("*").append(std::to_string(argc - 1)).append("\r\n");
+		for (int i = 1; i < argc; ++i) replyValue(arg(i, _key), nullptr);
+	} else if (is("MSET") && argc >= 3 && argc % 2 == 1) {
+		for (int i = 1; i < argc; i += 2) {
+			_store->write(arg(i, _key), nullptr, argv[i + 1], argvlen[i + 1]);
+		}
+		replyStatus("OK");
+	} else if (is("DEL") && argc >= 2) {
+		long long num_deleted = 0;
+		for (int i = 1; i < argc; ++i) {
+			num_deleted += _store->remove(arg(i, _key));
+		}
+		replyInteger(num_deleted);
+	} else if (is("EXISTS") && argc >= 2) {
+		long long num_existing = 0;
+		for (int i = 1; i < argc; ++i) {
+			num_existing += _store->exists(arg(i, _key));
+		}
+		replyInteger(num_existing);
+	} else if (is("HSET") && argc >= 4 && argc % 2 == 0) {
+		long long num_added = 0;
+		arg(1, _key);
+		for (int i = 2; i < argc; i += 2) {
+			num_added += _store->write(_key, &arg(i, _field), argv[i + 1],
+									   argvlen[i + 1]);
+		}
+		replyInteger(num_added);
+	} else if (is("HSETNX") && argc == 4) {
+		replyInteger(_store->write(arg(1, _key), &arg(2, _field), argv[3],
+								   argvlen[3], true));
+	} else if (is("HGET") && argc == 3) {
+		replyValue(arg(1, _key), &arg(2, _field));
+	} else if (is("HMGET") && argc >= 3) {
+		_reply.append("*").append(std::to_string(argc - 2)).append("\r\n");
+		arg(1, _key);
+		for (int i = 2; i < argc; ++i) replyValue(_key, &arg(i, _field));
+	} else {
+		replyError("ERR unknown command or wrong number of arguments for '" +
+				   std::string(argv[0], argvlen[0]) +
+				   "', not supported by " + _description);
+	}
+}
+
+void StoreTransport::replyError(const std::string& message) {
+	_reply.append("-").append(message).append("\r\n");
+}
+
+void StoreTransport::replyStatus(const char* status) {
+	_reply.append("+").append(status).append("\r\n");
+}
+
+void StoreTransport::replyInteger(const long long value) {
+	_reply.append(":").append(std::to_string(value)).append("\r\n");
+}
+
+void StoreTransport::replyNil() { _reply.append("$-1\r\n"); }
+
+void StoreTransport::replyValue(const std::string& key,
+								const std::string* field) {
+	if (!_store->read(key, field, _value)) return replyNil();
+	_reply.append("$").append(std::to_string(_value.size())).append("\r\n");
+	_reply.append(_value).append("\r\n");
+}
+
+}  // namespace SaiCommon
@@ -0,0 +1,115 @@
+#ifndef STORE_TRANSPORT_H
+#define STORE_TRANSPORT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RedisTransport.h"
+
+namespace SaiCommon {
+
+/**
+ * @brief Key-value store executing the commands of a StoreTransport in the
+ * calling thread. Holds string keys and hash fields.
+ */
+class KeyValueStore {
+public:
+	virtual ~KeyValueStore() = default;
+
+	/**
+	 * @brief Read the value of a key, or of a hash field if field is not null
+	 *
+	 * @return false if the key or field does not exist
+	 */
+	virtual bool read(const std::string& key, const std::string* field,
+					  std::string& value) const = 0;
+
+	/**
+	 * @brief Write the value of a key or hash field. Throws a
+	 * std::runtime_error if the store cannot hold it.
+	 *
+	 * @param only_if_absent  do not overwrite an existing value
+	 * @return true if the key or field did not exist (and was created)
+	 */
+	virtual bool write(const std::string& key, const std::string* field,
+					   const char* value, const size_t len,
+					   const bool only_if_absent = false) = 0;
+
+	/**
+	 * @brief Delete a key and, if it is a hash, all its fields
+	 *
+	 * @return true if something was deleted
+	 */
+	virtual bool remove(const std::string& key) = 0;
+
+	/**
+	 * @brief Whether a key (string or hash) exists
+	 */
+	virtual bool exists(const std::string& key) const = 0;
+};
+
+/**
+ * @brief Transport executing the commands directly on a KeyValueStore,
+ * without any server or socket.
+ *
+ * @details The commands are executed when they are appended. The supported
+ * commands are those used by the get/set functions and the send and receive
+ * groups: PING, GET, SET (with NX), MGET, MSET, DEL, EXISTS, HSET, HSETNX,
+ * HGET and HMGET. The other commands reply with an error.
+ */
+class StoreTransport : public RedisTransport {
+public:
+	/**
+	 * @brief Execute the commands on a store
+	 *
+	 * @param store        the store, shared with the other transports using it
+	 * @param description  address of the store, for display
+	 */
+	StoreTransport(std::shared_ptr<KeyValueStore> store,
+				   const std::string& description);
+	~StoreTransport() override;
+
+	// disallow copy and assign
+	StoreTransport(const StoreTransport&) = delete;
+	StoreTransport& operator=(const StoreTransport&) = delete;
+
+	int appendCommandArgv(const int argc, const char** argv,
+						  const size_t* argvlen) override;
+	int appendFormattedCommand(const char* command,
+							   const size_t len) override;
+	int getReply(redisReply** reply) override;
+	std::string description() const override { return _description; }
+
+private:
+	// execute a command and feed its reply, in the redis protocol, to the
+	// reader
+	void execute(const int argc, const char** argv, const size_t* argvlen);
+
+	// write the reply of a command to _reply
+	void reply(const int argc, const char** argv, const size_t* argvlen);
+
+	void replyError(const std::string& message);
+	void replyStatus(const char* status);
+	void replyInteger(const long long value);
+	void replyNil();
+	// a value read from the store, or nil
+	void replyValue(const std::string& key, const std::string* field);
+
+	const std::shared_ptr<KeyValueStore> _store;
+	const std::string _description;
+
+	// replies of the commands not read yet, parsed by a hiredis reader so
+	// that they are regular hiredis replies
+	redisReader* _reader;
+	size_t _num_pending = 0;
+
+	// buffers reused between commands
+	std::string _reply, _key, _field, _value;
+	std::vector<const char*> _argv;
+	std::vector<size_t> _argvlen;
+};
+
+}  // namespace SaiCommon
+
+#endif	// STORE_TRANSPORT_H
@@ -0,0 +1,95 @@
+// Checks that the Eigen objects of float and integer scalars are sent and
+// received with their own scalar type, in both encodings, without the loss
+// of a conversion to double. The values are exchanged through an in-process
+// endpoint, so that no server is needed.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "redis/RedisClient.h"
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+
+using Vector2l = Matrix<int64_t, 2, 1>;
+using RowMatrix2f = Matrix<float, 2, 2, RowMajor>;
+
+bool check(const string& name, const bool ok) {
+	cout << (ok ? "[ OK ] " : "[FAIL] ") << name << endl;
+	return ok;
+}
+
+}  // namespace
+
+int main() {
+	SaiCommon::RedisClient sender, receiver;
+	sender.connect("inprocess://test_eigen_scalar_types");
+	receiver.connect("inprocess://test_eigen_scalar_types");
+
+	// not representable exactly as doubles
+	const int64_t large = (int64_t(1) << 60) + 1;
+	const Vector3f floats(0.1f, -2.5f, 1e-7f);
+	const Vector2l int64s(large, -large);
+	RowMatrix2f row_major;
+	row_major << 0.1f, 0.2f, 0.3f, 0.4f;
+	const VectorXi ints = VectorXi::LinSpaced(5, -2, 2);
+	MatrixXf dynamic_floats(2, 3);
+	dynamic_floats << 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f;
+
+	const auto send_group = sender.createNewSendGroup("values");
+	sender.addToSendGroup("floats", floats, send_group);
+	sender.addToSendGroup("int64s", int64s, send_group);
+	sender.addToSendGroup("row_major", row_major, send_group);
+	sender.addToSendGroup("ints", ints, send_group);
+	sender.addToSendGroup("dynamic_floats", dynamic_floats, send_group);
+
+	Vector3f received_floats;
+	Vector2l received_int64s;
+	RowMatrix2f received_row_major;
+	VectorXi received_ints;
+	MatrixXf received_dynamic_floats;
+	const auto receive_group = receiver.createNewReceiveGroup("values");
+	receiver.addToReceiveGroup("floats", received_floats, receive_group);
+	receiver.addToReceiveGroup("int64s", received_int64s, receive_group);
+	receiver.addToReceiveGroup("row_major", received_row_major,
+							   receive_group);
+	receiver.addToReceiveGroup("ints", received_ints, receive_group);
+	receiver.addToReceiveGroup("dynamic_floats", received_dynamic_floats,
+							   receive_group);
+
+	bool ok = true;
+	for (const auto encoding : {SaiCommon::RedisClient::EIGEN_TEXT,
+								SaiCommon::RedisClient::EIGEN_BINARY}) {
+		const string name = encoding == SaiCommon::RedisClient::EIGEN_TEXT
+								? "text encoded "
+								: "binary encoded ";
+		sender.setEigenEncoding(encoding);
+		received_floats.setZero();
+		received_int64s.setZero();
+		received_row_major.setZero();
+		received_ints.resize(0);
+		received_dynamic_floats.resize(0, 0);
+		sender.sendAllFromGroup(send_group);
+		receiver.receiveAllFromGroup(receive_group);
+
+		ok &= check(name + "floats", received_floats == floats);
+		ok &= check(name + "large int64s", received_int64s == int64s);
+		ok &= check(name + "row major floats", received_row_major == row_major);
+		ok &= check(name + "ints", received_ints == ints);
+		ok &= check(name + "dynamic size floats",
+					received_dynamic_floats == dynamic_floats);
+	}
+
+	// the text of a float is the shortest one of the float itself
+	sender.setEigenEncoding(SaiCommon::RedisClient::EIGEN_TEXT);
+	sender.setEigen("floats", floats);
+	sender.setEigen("int64s", int64s);
+	ok &= check("float text", receiver.get("floats") == "[0.1,-2.5,1e-07]");
+	ok &= check("int64 text",
+				receiver.get("int64s") == "[" + to_string(large) + "," +
+											  to_string(-large) + "]");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+// Checks that receiving a group of registered Eigen objects does not
+// allocate once the group is set up. The values are exchanged through an
+// in-process endpoint, so that no server is needed.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "redis/RedisClient.h"
+
+using namespace std;
+using namespace Eigen;
+
+namespace {
+
+// number of operator new calls of the program. The allocations of hiredis
+// (malloc), which builds the replies, are not counted
+atomic<uint64_t> num_allocations(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+	num_allocations.fetch_add(1, memory_order_relaxed);
+	if (void* ptr = malloc(size == 0 ? 1 : size)) return ptr;
+	throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
+namespace {
+
+const int NUM_RECEIVES = 1000;
+
+// receive the group repeatedly and return the number of allocations
+uint64_t receiveAllocations(SaiCommon::RedisClient& client,
+							const SaiCommon::RedisClient::GroupHandle& group) {
+	// the first receive compiles the plan and sizes the buffers
+	client.receiveAllFromGroup(group);
+	const uint64_t num_allocations_before = num_allocations.load();
+	for (int i = 0; i < NUM_RECEIVES; ++i) {
+		client.receiveAllFromGroup(group);
+	}
+	return num_allocations.load() - num_allocations_before;
+}
+
+bool check(const string& name, const uint64_t allocations) {
+	if (allocations == 0) {
+		cout << "[ OK ] " << name << endl;
+		return true;
+	}
+	cout << "[FAIL] " << name << ": " << allocations << " allocations in "
+		 << NUM_RECEIVES << " receives" << endl;
+	return false;
+}
+
+}  // namespace
+
+int main() {
+	SaiCommon::RedisClient sender, receiver;
+	sender.connect("inprocess://test_receive_allocations");
+	receiver.connect("inprocess://test_receive_allocations");
+
+	const Matrix3d rotation = Matrix3d::Random();
+	const VectorXd joint_positions = VectorXd::Random(7);
+
+	Matrix3d received_rotation;
+	VectorXd received_joint_positions = VectorXd::Zero(7);
+	const auto group = receiver.createNewReceiveGroup("robot");
+	receiver.addToReceiveGroup("rotation", received_rotation, group);
+	receiver.addToReceiveGroup("joint_positions", received_joint_positions,
+							   group);
+
+	bool ok = true;
+	for (const auto encoding : {SaiCommon::RedisClient::EIGEN_TEXT,
+								SaiCommon::RedisClient::EIGEN_BINARY}) {
+		sender.setEigenEncoding(encoding);
+		sender.setEigen("rotation", rotation);
+		sender.setEigen("joint_positions", joint_positions);
+		const string name = encoding == SaiCommon::RedisClient::EIGEN_TEXT
+								? "text encoded Eigen values"
+								: "binary encoded Eigen values";
+		ok &= check(name, receiveAllocations(receiver, group));
+		if (!received_rotation.isApprox(rotation, 1e-6) ||
+			!received_joint_positions.isApprox(joint_positions, 1e-6)) {
+			cout << "[FAIL] " << name << ": wrong values received" << endl;
+			ok = false;
+		}
+	}
+	return ok ? 0 : 1;
+}